@@ -0,0 +1,130 @@
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+class TBenchmarkState {
+private:
+    size_t iterations;
+    size_t done = 0;
+
+    // the clock is read before every batch of iterations and after the last
+    size_t batch_size;
+    std::vector<std::chrono::steady_clock::time_point> marks;
+
+    size_t items_per_iteration = 1;
+    size_t bytes_per_iteration = 0;
+public:
+    // iterations have to be a multiple of the batch size
+    explicit TBenchmarkState(size_t iterations, size_t batch_size = 1)
+        : iterations(iterations)
+        , batch_size(batch_size)
+    {
+        marks.reserve(iterations / batch_size + 1);
+    }
+
+    bool keep_running()
+    {
+        if (done % batch_size == 0)
+            marks.push_back(std::chrono::steady_clock::now());
+        return done++ < iterations;
+    }
+
+    // seconds per iteration of every batch
+    [[nodiscard]]
+    std::vector<double> batch_times() const
+    {
+        std::vector<double> times;
+        for (size_t i = 1; i < marks.size(); i++)
+        {
+            times.push_back(std::chrono::duration<double>(marks[i] - marks[i - 1]).count() / (double)batch_size);
+        }
+        return times;
+    }
+
+    [[nodiscard]]
+    size_t get_iterations() const noexcept
+    {
+        return iterations;
+    }
+
+    // amount of work a single iteration represents, used for throughput
+    void set_items(size_t items)
+    {
+        items_per_iteration = items;
+    }
+    void set_bytes(size_t bytes)
+    {
+        bytes_per_iteration = bytes;
+    }
+
+    [[nodiscard]] size_t get_items() const noexcept { return items_per_iteration; }
+    [[nodiscard]] size_t get_bytes() const noexcept { return bytes_per_iteration; }
+};
+
+struct TBenchmark {
+    std::string name;
+    std::function<void (TBenchmarkState&)> body;
+
+    static std::vector<TBenchmark>& registry()
+    {
+        static std::vector<TBenchmark> benchmarks;
+        return benchmarks;
+    }
+};
+
+struct TBenchmarkRegistrar {
+    TBenchmarkRegistrar(const char* name, std::function<void (TBenchmarkState&)> body)
+    {
+        TBenchmark::registry().push_back({ name, std::move(body) });
+    }
+};
+
+template<typename T>
+inline void do_not_optimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+// largest input size reports scale up to, 10^6 tokens unless --large was given
+size_t report_max_tokens();
+
+// free-form measurements that are printed rather than timed
+struct TReport {
+    std::string name;
+    std::function<void ()> body;
+
+    static std::vector<TReport>& registry()
+    {
+        static std::vector<TReport> reports;
+        return reports;
+    }
+};
+
+struct TReportRegistrar {
+    TReportRegistrar(const char* name, std::function<void ()> body)
+    {
+        TReport::registry().push_back({ name, std::move(body) });
+    }
+};
+
+#define REPORT(name)                                                           \
+    static void report_##name();                                               \
+    static TReportRegistrar report_##name##_registrar(#name, report_##name);   \
+    static void report_##name()
+
+#define BENCHMARK(name)                                                        \
+    static void bench_##name(TBenchmarkState&);                                \
+    static TBenchmarkRegistrar bench_##name##_registrar(#name, bench_##name);  \
+    static void bench_##name(TBenchmarkState& state)
+
+#endif // __BENCH_H__
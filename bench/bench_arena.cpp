@@ -0,0 +1,37 @@
+#include "bench.h"
+#include "postfix.h"
+#include "catalog.h"
+#include <memory_resource>
+#include <vector>
+
+static const size_t ARENA_EXPRESSIONS = 100000;
+
+BENCHMARK(construct_destroy_heap)
+{
+    state.set_items(ARENA_EXPRESSIONS);
+    while (state.keep_running())
+    {
+        std::vector<TArithmeticExpression> expressions;
+        expressions.reserve(ARENA_EXPRESSIONS);
+        for (size_t i = 0; i < ARENA_EXPRESSIONS; i++)
+            expressions.emplace_back(catalog()[i % catalog().size()]);
+        do_not_optimize(expressions);
+    }
+}
+
+BENCHMARK(construct_destroy_arena)
+{
+    // the arena memory is reused between runs like a long-lived catalog arena would be
+    static std::vector<char> buffer(256 << 20);
+
+    state.set_items(ARENA_EXPRESSIONS);
+    while (state.keep_running())
+    {
+        std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size());
+        std::vector<TArithmeticExpression> expressions;
+        expressions.reserve(ARENA_EXPRESSIONS);
+        for (size_t i = 0; i < ARENA_EXPRESSIONS; i++)
+            expressions.emplace_back(catalog()[i % catalog().size()], &arena);
+        do_not_optimize(expressions);
+    }
+}
@@ -0,0 +1,27 @@
+#include "bench.h"
+#include "bulk.h"
+#include "catalog.h"
+
+BENCHMARK(bulk_sequential)
+{
+    state.set_items(catalog().size());
+    state.set_bytes(catalog_bytes());
+    while (state.keep_running())
+    {
+        std::vector<TCompilationResult> results;
+        results.reserve(catalog().size());
+        for (const auto& infix : catalog())
+            results.push_back(try_compile(infix));
+        do_not_optimize(results);
+    }
+}
+
+BENCHMARK(bulk_parallel)
+{
+    state.set_items(catalog().size());
+    state.set_bytes(catalog_bytes());
+    while (state.keep_running())
+    {
+        do_not_optimize(compile_bulk(catalog()));
+    }
+}
@@ -0,0 +1,22 @@
+#include "bench.h"
+#include "cache.h"
+
+static const std::string infix = "((a+(b*c)+((4*d)+7)/sin(8*e))+func(2*a))*2";
+
+BENCHMARK(cache_miss_compile)
+{
+    while (state.keep_running())
+    {
+        TArithmeticExpression expr(infix);
+        do_not_optimize(expr);
+    }
+}
+
+BENCHMARK(cache_hit)
+{
+    TArithmeticExpressionCache cache;
+    while (state.keep_running())
+    {
+        do_not_optimize(cache.get(infix));
+    }
+}
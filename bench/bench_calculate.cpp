@@ -0,0 +1,89 @@
+#include "bench.h"
+#include "postfix.h"
+#include "catalog.h"
+#include "eval_profile.h"
+#include <cstdio>
+
+static const TArithmeticExpression& expression()
+{
+    static const TArithmeticExpression expr("((a+(b*c)+((4*d)+7)/sin(8*e))+func(2*a))*2");
+    return expr;
+}
+
+static const std::shared_ptr<TArithmeticExpressionFunction> func =
+        std::make_shared<TComputedArithmeticExpressionFunction>([](double x) { return x * x; });
+
+BENCHMARK(calculate_numbers)
+{
+    const TArithmeticExpression expr("((((((1+2)+3)+4)+5)+6)+7)+8*9/10");
+    while (state.keep_running())
+    {
+        do_not_optimize(expr.calculate());
+    }
+}
+
+BENCHMARK(calculate_variables)
+{
+    const TArithmeticExpression expr("((a+(b*c)+((4*d)+7)/(8*e))+(2*a))*2");
+    TExpressionBindings bindings;
+    bindings.set("a", 1);
+    bindings.set("b", 2);
+    bindings.set("c", 3);
+    bindings.set("d", 4);
+    bindings.set("e", 5);
+    while (state.keep_running())
+    {
+        do_not_optimize(expr.calculate(bindings));
+    }
+}
+
+BENCHMARK(calculate_map)
+{
+    const std::map<std::string, double> values = { { "a", 1 }, { "b", 2 }, { "c", 3 }, { "d", 4 }, { "e", 5 } };
+    const std::map<std::string, std::shared_ptr<TArithmeticExpressionFunction>> functions = { { "func", func } };
+    while (state.keep_running())
+    {
+        do_not_optimize(expression().calculate(values, functions));
+    }
+}
+
+BENCHMARK(calculate_bindings)
+{
+    TExpressionBindings bindings;
+    bindings.set("a", 1);
+    bindings.set("b", 2);
+    bindings.set("c", 3);
+    bindings.set("d", 4);
+    bindings.set("e", 5);
+    bindings.set_function("func", func);
+    while (state.keep_running())
+    {
+        do_not_optimize(expression().calculate(bindings));
+    }
+}
+
+REPORT(evaluation_profile)
+{
+    if (!TEvaluationProfile::enabled())
+    {
+        printf("  configure with -DPOSTFIX_PROFILE_EVAL=ON to profile evaluation\n");
+        return;
+    }
+
+    TExpressionBindings bindings;
+    for (const char* name : { "price", "qty", "rate", "x", "y", "z", "base", "delta" })
+    {
+        bindings.set(name, 1.5);
+    }
+
+    TEvaluationProfile::reset();
+    for (const auto& infix : catalog())
+    {
+        const TArithmeticExpression expr(infix);
+        for (int i = 0; i < 10; i++)
+        {
+            do_not_optimize(expr.calculate(bindings));
+        }
+    }
+    printf("%s", TEvaluationProfile::report(10).c_str());
+}
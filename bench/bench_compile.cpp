@@ -0,0 +1,116 @@
+#include "bench.h"
+#include "postfix.h"
+#include "validator.h"
+#include "catalog.h"
+#include "compile_stats.h"
+#include <cstdio>
+
+static const std::vector<std::string>& formulas()
+{
+    static const std::vector<std::string> corpus = {
+        "1+2",
+        "a+2",
+        "a+(b*c)+((4*d)+7)",
+        "((((((1+2)+3)+4)+5)+6)+7)+8",
+        "-5 + ((-100)*((-3)-(-3)))",
+        "-5! + 10 - (-3)",
+        "-a+b*(-func(a))",
+        "((a+(b*c)+((4*d)+7)/sin(8*e))+func(2*a))*2",
+        "cos(pi) * radius ^ 2 + sqrt(x * x + y * y)",
+        "3.14159 * 2.71828 / 1.41421 + 0.57721 - 1.61803 * 4.66920",
+    };
+    return corpus;
+}
+
+static size_t corpus_bytes()
+{
+    size_t bytes = 0;
+    for (const auto& infix : formulas())
+        bytes += infix.size();
+    return bytes;
+}
+
+BENCHMARK(validate_infix)
+{
+    state.set_items(formulas().size());
+    state.set_bytes(corpus_bytes());
+    while (state.keep_running())
+    {
+        for (const auto& infix : formulas())
+            do_not_optimize(validate_infix(infix));
+    }
+}
+
+BENCHMARK(compile)
+{
+    state.set_items(formulas().size());
+    state.set_bytes(corpus_bytes());
+    while (state.keep_running())
+    {
+        for (const auto& infix : formulas())
+        {
+            TArithmeticExpression expr(infix);
+            do_not_optimize(expr);
+        }
+    }
+}
+
+BENCHMARK(compile_numeric)
+{
+    static const std::string infix =
+            "3.14159265358979 * 2.71828182845904 / 1.41421356237309 + 0.57721566490153"
+            " - 1.61803398874989 * 4.66920160910299 + 2.50290787509589 * 0.91596559417721"
+            " + 1.20205690315959 / 0.30102999566398 - 6.02214076 * 1.380649 + 299792458";
+
+    state.set_bytes(infix.size());
+    while (state.keep_running())
+    {
+        TArithmeticExpression expr(infix);
+        do_not_optimize(expr);
+    }
+}
+
+REPORT(memory_per_expression)
+{
+    size_t total = 0, tokens = 0;
+    for (const auto& infix : catalog())
+    {
+        const TArithmeticExpression expr(infix);
+        total += expr.memory_usage();
+        tokens += expr.get_postfix().size();
+    }
+
+    const double count = (double)catalog().size();
+    printf("  tokens per expression          %10.1f\n", (double)tokens / count);
+    printf("  program bytes, TPostfixToken   %10.1f (%zu bytes per token)\n",
+           (double)tokens * sizeof(TPostfixToken) / count, sizeof(TPostfixToken));
+    printf("  program bytes, TLexeme         %10.1f (%zu bytes per token, names on the heap)\n",
+           (double)tokens * sizeof(TLexeme) / count, sizeof(TLexeme));
+    printf("  expression bytes, total        %10.1f\n", (double)total / count);
+}
+
+REPORT(compile_phases)
+{
+    if (!TCompileStats::enabled())
+    {
+        printf("  configure with -DPOSTFIX_COMPILE_STATS=ON to collect phase timings\n");
+        return;
+    }
+
+    TCompileStats::reset_global();
+    for (const auto& infix : catalog())
+    {
+        const TArithmeticExpression expr(infix);
+    }
+
+    const TCompileStats stats = TCompileStats::global();
+    const double count = (double)stats.compilations;
+    for (size_t i = 0; i < (size_t)TCompileStats::Phase::Count; i++)
+    {
+        printf("  %-10s %10.1f ns/expression %6.1f%%\n", TCompileStats::phase_name((TCompileStats::Phase)i),
+               (double)stats.phase_ns[i] / count, 100.0 * (double)stats.phase_ns[i] / (double)stats.total_ns());
+    }
+    printf("  tokens per expression      %10.1f\n", (double)stats.tokens / count);
+    printf("  list allocations/expression%9.1f\n", (double)stats.list_allocations / count);
+    printf("  operator stack high water  %10llu\n", (unsigned long long)stats.stack_high_water);
+}
@@ -0,0 +1,203 @@
+#include "bench.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+using clock_type = std::chrono::steady_clock;
+
+// usage: bench_postfix [filter] [--repetitions=N] [--min-time=SECONDS] [--json=FILE] [--large]
+struct TOptions {
+    const char* filter = nullptr;
+    size_t repetitions = 10;
+    // per repetition
+    double min_time = 0.05;
+    const char* json = nullptr;
+    // reports also scale to 10^7 tokens, which takes seconds and gigabytes
+    bool large = false;
+};
+
+static bool large_reports = false;
+
+size_t report_max_tokens()
+{
+    return large_reports ? 10000000 : 1000000;
+}
+
+struct TResult {
+    std::string name;
+    size_t iterations;
+    size_t items;
+    size_t bytes;
+
+    // seconds per iteration of every batch of every repetition, sorted
+    std::vector<double> samples;
+
+    [[nodiscard]]
+    double percentile(double p) const
+    {
+        // nearest rank
+        const size_t rank = (size_t)std::ceil(p * (double)samples.size());
+        return samples[std::max<size_t>(rank, 1) - 1];
+    }
+    [[nodiscard]]
+    double mean() const
+    {
+        double sum = 0;
+        for (const double s : samples)
+            sum += s;
+        return sum / (double)samples.size();
+    }
+};
+
+static bool parse_options(int argc, char** argv, TOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        if (!strncmp(arg, "--repetitions=", 14))
+            options.repetitions = std::max(1, atoi(arg + 14));
+        else if (!strncmp(arg, "--min-time=", 11))
+            options.min_time = atof(arg + 11);
+        else if (!strncmp(arg, "--json=", 7))
+            options.json = arg + 7;
+        else if (!strcmp(arg, "--large"))
+            options.large = true;
+        else if (arg[0] == '-')
+            return false;
+        else
+            options.filter = arg;
+    }
+    return true;
+}
+
+// repetitions are timed in this many batches, so percentiles see more than one sample per repetition
+static const size_t BATCHES = 100;
+
+static double run(const TBenchmark& bench, size_t iterations, size_t batch_size, TBenchmarkState& state)
+{
+    state = TBenchmarkState(iterations, batch_size);
+
+    const auto start = clock_type::now();
+    bench.body(state);
+    const auto end = clock_type::now();
+
+    return std::chrono::duration<double>(end - start).count();
+}
+
+static TResult measure(const TBenchmark& bench, const TOptions& options)
+{
+    TBenchmarkState state(1);
+    size_t iterations = 1;
+    // the first run pays for lazily built fixtures, do not calibrate on it
+    run(bench, iterations, iterations, state);
+    double elapsed = run(bench, iterations, iterations, state);
+    while (elapsed < options.min_time)
+    {
+        iterations *= elapsed > 0 ? std::min<size_t>(10, size_t(options.min_time / elapsed * 1.5) + 1) : 10;
+        elapsed = run(bench, iterations, iterations, state);
+    }
+
+    // slow benchmarks get fewer batches of a single iteration
+    const size_t batch_size = std::max<size_t>(1, iterations / BATCHES);
+    iterations = (iterations + batch_size - 1) / batch_size * batch_size;
+
+    TResult result = { bench.name, iterations, state.get_items(), state.get_bytes(), {} };
+    for (size_t r = 0; r < options.repetitions; r++)
+    {
+        run(bench, iterations, batch_size, state);
+        const std::vector<double> times = state.batch_times();
+        result.samples.insert(result.samples.end(), times.begin(), times.end());
+    }
+    std::sort(result.samples.begin(), result.samples.end());
+    return result;
+}
+
+static void print(const TResult& result)
+{
+    const double median = result.percentile(0.5);
+    printf("%-32s %12.1f ns/op %12.1f p99 %14.1f ops/s", result.name.c_str(),
+           median * 1e9, result.percentile(0.99) * 1e9, 1 / median);
+    if (result.items != 1)
+    {
+        printf(" %14.1f items/s", (double)result.items / median);
+    }
+    if (result.bytes > 0)
+    {
+        printf(" %10.2f MB/s", (double)result.bytes / median / 1e6);
+    }
+    printf("\n");
+}
+
+// names come from BENCHMARK and need no escaping
+static bool write_json(const char* path, const TOptions& options, const std::vector<TResult>& results)
+{
+    FILE* out = fopen(path, "w");
+    if (!out)
+        return false;
+
+    char date[32];
+    const time_t now = time(nullptr);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    fprintf(out, "{\n  \"context\": { \"date\": \"%s\", \"repetitions\": %zu, \"min_time\": %g },\n",
+            date, options.repetitions, options.min_time);
+    fprintf(out, "  \"benchmarks\": [");
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const TResult& r = results[i];
+        const double median = r.percentile(0.5);
+        fprintf(out, "%s\n    { \"name\": \"%s\", \"iterations\": %zu, \"samples\": %zu,"
+                     " \"median_ns\": %.3f, \"p99_ns\": %.3f, \"min_ns\": %.3f, \"mean_ns\": %.3f,"
+                     " \"ops_per_second\": %.3f, \"items_per_second\": %.3f, \"bytes_per_second\": %.3f }",
+                i > 0 ? "," : "", r.name.c_str(), r.iterations, r.samples.size(),
+                median * 1e9, r.percentile(0.99) * 1e9, r.samples.front() * 1e9, r.mean() * 1e9,
+                1 / median, (double)r.items / median, (double)r.bytes / median);
+    }
+    fprintf(out, "\n  ]\n}\n");
+
+    return fclose(out) == 0;
+}
+
+int main(int argc, char** argv)
+{
+    TOptions options;
+    if (!parse_options(argc, argv, options))
+    {
+        fprintf(stderr, "usage: %s [filter] [--repetitions=N] [--min-time=SECONDS] [--json=FILE] [--large]\n",
+                argv[0]);
+        return EXIT_FAILURE;
+    }
+    large_reports = options.large;
+
+    for (const auto& report : TReport::registry())
+    {
+        if (options.filter && !strstr(report.name.c_str(), options.filter))
+            continue;
+
+        printf("%s:\n", report.name.c_str());
+        report.body();
+    }
+
+    std::vector<TResult> results;
+    for (const auto& bench : TBenchmark::registry())
+    {
+        if (options.filter && !strstr(bench.name.c_str(), options.filter))
+            continue;
+
+        results.push_back(measure(bench, options));
+        print(results.back());
+    }
+
+    if (options.json && !write_json(options.json, options, results))
+    {
+        fprintf(stderr, "Cannot write %s\n", options.json);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
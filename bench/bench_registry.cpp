@@ -0,0 +1,67 @@
+#include "bench.h"
+#include "catalog.h"
+#include "registry.h"
+#include <cstdio>
+#include <fstream>
+
+static const std::string& catalog_path()
+{
+    static const std::string path = []() {
+        const std::string name = "bench_registry_catalog.txt";
+        std::ofstream out(name);
+        for (size_t i = 0; i < catalog().size(); i++)
+        {
+            out << "f" << i << " = " << catalog()[i] << '\n';
+        }
+        return name;
+    }();
+    static const struct TCleanup {
+        ~TCleanup() { std::remove(catalog_path().c_str()); }
+    } cleanup;
+    return path;
+}
+
+BENCHMARK(registry_getline_loop)
+{
+    state.set_items(catalog().size());
+    while (state.keep_running())
+    {
+        std::ifstream in(catalog_path());
+        std::map<std::string, std::shared_ptr<TArithmeticExpression>> formulas;
+
+        std::string line;
+        while (std::getline(in, line))
+        {
+            const size_t eq = line.find('=');
+            formulas[line.substr(0, eq - 1)] = std::make_shared<TArithmeticExpression>(line.substr(eq + 1));
+        }
+        do_not_optimize(formulas);
+    }
+}
+
+BENCHMARK(registry_load)
+{
+    state.set_items(catalog().size());
+    while (state.keep_running())
+    {
+        do_not_optimize(TFormulaRegistry::load(catalog_path()));
+    }
+}
+
+BENCHMARK(registry_load_image)
+{
+    static const std::string image_path = []() {
+        const std::string path = "bench_registry_catalog.bin";
+        TFormulaRegistry::load(catalog_path()).save_image(path);
+        return path;
+    }();
+    static const struct TCleanup {
+        ~TCleanup() { std::remove(image_path.c_str()); }
+    } cleanup;
+
+    state.set_items(catalog().size());
+    while (state.keep_running())
+    {
+        do_not_optimize(TFormulaRegistry::load_image(image_path));
+    }
+}
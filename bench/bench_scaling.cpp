@@ -0,0 +1,105 @@
+#include "bench.h"
+#include "postfix.h"
+#include "validator.h"
+#include "generator.h"
+#include "image.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+using clock_type = std::chrono::steady_clock;
+
+static double seconds_since(clock_type::time_point start)
+{
+    return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+// a+(a+(a+...)) with every level in brackets: deep stacks in every phase
+static std::string right_nested(size_t tokens)
+{
+    const size_t depth = tokens / 4;
+    std::string infix;
+    infix.reserve(depth * 4 + 1);
+    for (size_t i = 0; i < depth; i++)
+    {
+        infix += "a+(";
+    }
+    infix += "a";
+    infix.append(depth, ')');
+    return infix;
+}
+
+REPORT(scaling_right_nested)
+{
+    printf("  %10s %14s %14s %14s\n", "tokens", "validate ns/t", "compile ns/t", "calculate ns/t");
+    for (size_t tokens = 1000; tokens <= report_max_tokens(); tokens *= 10)
+    {
+        const std::string infix = right_nested(tokens);
+
+        auto start = clock_type::now();
+        validate_infix(infix);
+        const double validate = seconds_since(start);
+
+        start = clock_type::now();
+        const TArithmeticExpression expr(infix);
+        const double compile = seconds_since(start);
+
+        TExpressionBindings bindings;
+        bindings.set("a", 1);
+        start = clock_type::now();
+        do_not_optimize(expr.calculate(bindings));
+        const double calculate = seconds_since(start);
+
+        printf("  %10zu %14.1f %14.1f %14.1f\n", tokens,
+               validate * 1e9 / (double)tokens, compile * 1e9 / (double)tokens, calculate * 1e9 / (double)tokens);
+    }
+}
+
+// average seconds per run of body, repeated for at least ~10^6 tokens of work
+template<class Body>
+static double per_run(size_t tokens, Body body)
+{
+    const size_t runs = std::max<size_t>(1, 1000000 / tokens);
+    const auto start = clock_type::now();
+    for (size_t i = 0; i < runs; i++)
+    {
+        body();
+    }
+    return seconds_since(start) / (double)runs;
+}
+
+REPORT(scaling_generated)
+{
+    printf("  %10s %10s %12s %12s %12s %12s %12s\n", "tokens", "bytes",
+           "validate", "compile", "postfix", "image", "calculate");
+    for (size_t tokens = 10; tokens <= report_max_tokens(); tokens *= 10)
+    {
+        TGeneratorOptions options;
+        options.tokens = tokens;
+        TExpressionGenerator generator(options, tokens);
+        const std::string infix = generator.next();
+
+        TExpressionBindings bindings;
+        for (const auto& name : generator.variable_names())
+        {
+            bindings.set(name, 1.5);
+        }
+
+        const double validate = per_run(tokens, [&]() { validate_infix(infix); });
+        const double compile = per_run(tokens, [&]() { do_not_optimize(TArithmeticExpression(infix)); });
+
+        const TArithmeticExpression expr(infix);
+        const double postfix = per_run(tokens, [&]() {
+            // copies start without the cached text
+            const TArithmeticExpression copy(expr);
+            do_not_optimize(copy.get_postfix_text());
+        });
+        const double image = per_run(tokens, [&]() { do_not_optimize(TExpressionImage::encode(expr)); });
+        const double calculate = per_run(tokens, [&]() { do_not_optimize(expr.calculate(bindings)); });
+
+        const double n = (double)expr.get_postfix().size();
+        printf("  %10.0f %10zu %12.1f %12.1f %12.1f %12.1f %12.1f\n", n, infix.size(),
+               validate * 1e9 / n, compile * 1e9 / n, postfix * 1e9 / n, image * 1e9 / n, calculate * 1e9 / n);
+    }
+    printf("  (ns per token)\n");
+}
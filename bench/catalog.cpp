@@ -0,0 +1,41 @@
+#include "catalog.h"
+#include <random>
+
+const std::vector<std::string>& catalog()
+{
+    static const std::vector<std::string> formulas = []() {
+        std::mt19937 rng(42);
+        const char* const ops = "+-*/";
+        const char* const names[] = { "price", "qty", "rate", "x", "y", "z", "base", "delta" };
+
+        std::vector<std::string> result;
+        for (int i = 0; i < 20000; i++)
+        {
+            std::string infix;
+            const int terms = 3 + (int)(rng() % 12);
+            for (int t = 0; t < terms; t++)
+            {
+                if (t > 0)
+                    infix += ops[rng() % 4];
+                switch (rng() % 4)
+                {
+                    case 0: infix += std::to_string(rng() % 1000) + "." + std::to_string(rng() % 100); break;
+                    case 1: infix += "sin(" + std::string(names[rng() % 8]) + ")"; break;
+                    case 2: infix += "(" + std::string(names[rng() % 8]) + "+" + std::to_string(rng() % 10) + ")"; break;
+                    default: infix += names[rng() % 8]; break;
+                }
+            }
+            result.push_back(infix);
+        }
+        return result;
+    }();
+    return formulas;
+}
+
+size_t catalog_bytes()
+{
+    size_t bytes = 0;
+    for (const auto& infix : catalog())
+        bytes += infix.size();
+    return bytes;
+}
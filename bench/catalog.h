@@ -0,0 +1,11 @@
+#ifndef __CATALOG_H__
+#define __CATALOG_H__
+
+#include <string>
+#include <vector>
+
+// a fixed synthetic catalog of formulas resembling the production ones
+const std::vector<std::string>& catalog();
+size_t catalog_bytes();
+
+#endif // __CATALOG_H__
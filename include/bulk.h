@@ -0,0 +1,42 @@
+#ifndef __BULK_H__
+#define __BULK_H__
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "postfix.h"
+#include "parallel.h"
+
+struct TCompilationError {
+    std::string message;
+    size_t pos = 0;
+    expression_validation_error::cause cause = expression_validation_error::cause::Generic;
+};
+
+// Outcome of compiling a single infix: either the expression or the error it failed with
+struct TCompilationResult {
+    std::shared_ptr<const TArithmeticExpression> expression;
+    TCompilationError error;
+
+    [[nodiscard]]
+    bool ok() const noexcept
+    {
+        return expression != nullptr;
+    }
+};
+
+// Compiles a single expression, reporting failures as a value instead of an exception
+[[nodiscard]]
+TCompilationResult try_compile(std::string_view infix);
+
+// Compiles all expressions on the pool, results are in input order
+[[nodiscard]]
+std::vector<TCompilationResult> compile_bulk(const std::vector<std::string>& infixes,
+                                             TThreadPool& pool = TThreadPool::shared());
+// the same for views into text owned by the caller, such as a mapped file
+[[nodiscard]]
+std::vector<TCompilationResult> compile_bulk(const std::vector<std::string_view>& infixes,
+                                             TThreadPool& pool = TThreadPool::shared());
+
+#endif // __BULK_H__
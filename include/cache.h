@@ -0,0 +1,62 @@
+#ifndef __CACHE_H__
+#define __CACHE_H__
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "postfix.h"
+
+// Thread-safe bounded cache of compiled expressions keyed by their infix text.
+// Keys are normalized by dropping the whitespace the compiler skips,
+// entries are split across independently locked shards, each evicting in LRU order
+class TArithmeticExpressionCache {
+public:
+    using TEntry = std::shared_ptr<const TArithmeticExpression>;
+
+    struct TStatistics {
+        size_t hits;
+        size_t misses;
+        size_t evictions;
+    };
+private:
+    struct TShard {
+        std::mutex mutex;
+
+        // most recently used first
+        std::list<std::pair<std::string, TEntry>> order;
+        std::unordered_map<std::string, decltype(order)::iterator> index;
+
+        std::atomic<size_t> hits { 0 };
+        std::atomic<size_t> misses { 0 };
+        std::atomic<size_t> evictions { 0 };
+    };
+
+    const size_t shard_capacity;
+    std::vector<std::unique_ptr<TShard>> shards;
+
+    TShard& shard_for(const std::string& key) const;
+public:
+    explicit
+    TArithmeticExpressionCache(size_t capacity = 4096, size_t shard_count = 16);
+
+    // Returns the cached expression for the infix, compiling it on a miss.
+    // Validation errors are thrown as by the constructor and are never cached
+    TEntry get(const std::string& infix);
+
+    [[nodiscard]] TStatistics statistics() const;
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] size_t capacity() const noexcept;
+
+    void clear();
+
+    [[nodiscard]]
+    static std::string normalize(const std::string& infix);
+
+    static TArithmeticExpressionCache& global();
+};
+
+#endif // __CACHE_H__
@@ -0,0 +1,71 @@
+#ifndef __COLUMN_FILE_H__
+#define __COLUMN_FILE_H__
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "postfix.h"
+#include "parallel.h"
+#include "mapped_file.h"
+
+class column_file_error : public std::runtime_error
+{
+public:
+    explicit
+    column_file_error(const std::string &message)
+        : runtime_error(message)
+    {}
+};
+
+// Packed little-endian doubles mapped straight from disk and evaluated in place.
+//
+// raw:          nothing but the values of a single column
+// interleaved:  "PFXC", u32 version, u32 column count, u32 offset of the values
+//               (a multiple of 8), u64 row count, column names as (u32 length,
+//               bytes), zero padding, then the values row by row
+class TColumnFile {
+private:
+    TMappedFile file;
+    std::vector<std::string> names;
+    // first value of the first column, rows are names.size() values apart
+    const double* values = nullptr;
+    size_t row_count = 0;
+public:
+    static constexpr uint32_t VERSION = 1;
+
+    TColumnFile() = default;
+
+    [[nodiscard]]
+    static TColumnFile open_raw(const std::string& path, const std::string& name);
+    [[nodiscard]]
+    static TColumnFile open_interleaved(const std::string& path);
+
+    static void write_interleaved(const std::string& path, const std::vector<std::string>& names,
+                                  const std::vector<const double*>& columns, size_t rows);
+
+    [[nodiscard]] size_t rows() const noexcept { return row_count; }
+    [[nodiscard]] const std::vector<std::string>& columns() const noexcept { return names; }
+
+    // the values of a column, stride() doubles apart
+    [[nodiscard]]
+    const double* column(size_t index) const noexcept
+    {
+        return values + index;
+    }
+    [[nodiscard]]
+    size_t stride() const noexcept
+    {
+        return names.size();
+    }
+};
+
+// Evaluates the expression over every row of the inputs, whose columns bind
+// the variables of the same name, and writes the results as a raw column
+// file. Rows are evaluated on the pool straight from the mapped inputs into
+// the mapped output. Returns the number of rows
+size_t evaluate_column_files(const TArithmeticExpression& expression, const TExpressionBindings& bindings,
+                             const std::vector<const TColumnFile*>& inputs, const std::string& output_path,
+                             TThreadPool& pool = TThreadPool::shared());
+
+#endif // __COLUMN_FILE_H__
@@ -0,0 +1,71 @@
+#ifndef __COMPILE_STATS_H__
+#define __COMPILE_STATS_H__
+
+#include <cstddef>
+#include <cstdint>
+
+// Per-phase timings and counters of expression compilation. Collected only
+// in builds configured with -DPOSTFIX_COMPILE_STATS=ON; otherwise the
+// compiler carries no instrumentation and every figure stays zero
+struct TCompileStats {
+    enum class Phase : uint8_t {
+        Validate,
+        Lex,
+        Shunt,
+        Emit,
+        Finalize,
+
+        Count
+    };
+
+    uint64_t compilations = 0;
+    uint64_t failures = 0;
+
+    // exclusive time per phase
+    uint64_t phase_ns[(size_t)Phase::Count] = {};
+
+    uint64_t tokens = 0;
+    // deepest operator stack, the maximum over all compilations
+    uint64_t stack_high_water = 0;
+    // heap allocations of TDynamicList storage made while compiling on the
+    // thread: the program and the stacks of the compiler and validator.
+    // Other allocations, such as the infix copy or new symbol names, are not
+    // counted
+    uint64_t list_allocations = 0;
+
+    TCompileStats& operator+=(const TCompileStats& other);
+
+    [[nodiscard]]
+    uint64_t total_ns() const;
+
+    [[nodiscard]]
+    static const char* phase_name(Phase phase);
+
+    [[nodiscard]]
+    static constexpr bool enabled()
+    {
+#ifdef POSTFIX_COMPILE_STATS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // aggregate over every compilation in the process so far
+    [[nodiscard]]
+    static TCompileStats global();
+    static void reset_global();
+
+    // statistics of the latest compilation on the calling thread
+    [[nodiscard]]
+    static TCompileStats last();
+
+#ifdef POSTFIX_COMPILE_STATS
+    // list allocations on the calling thread so far, see list_allocation_hook
+    [[nodiscard]]
+    static uint64_t thread_list_allocations() noexcept;
+    static void count_list_allocation() noexcept;
+#endif
+};
+
+#endif // __COMPILE_STATS_H__
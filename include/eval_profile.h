@@ -0,0 +1,49 @@
+#ifndef __EVAL_PROFILE_H__
+#define __EVAL_PROFILE_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Per-operation profile of TArithmeticExpression::calculate. Collected only
+// in builds configured with -DPOSTFIX_PROFILE_EVAL=ON, where every executed
+// token is counted and timed in cycles (rdtsc where available, nanoseconds
+// elsewhere) and attributed back to its position in the infix
+class TEvaluationProfile {
+public:
+    struct TEntry {
+        // "operator +", "function sin", "variable x", "number";
+        // for subexpressions the infix followed by the subexpression text
+        std::string label;
+        uint64_t count;
+        uint64_t cycles;
+    };
+
+    [[nodiscard]]
+    static constexpr bool enabled()
+    {
+#ifdef POSTFIX_PROFILE_EVAL
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // operations of all expressions evaluated so far, by total cycles
+    [[nodiscard]]
+    static std::vector<TEntry> hottest_operations(size_t limit = 10);
+
+    // Subexpressions rooted at each operation, by the total cycles of the
+    // operation itself, one entry per position in the infix. Labels are
+    // "<infix>: <subexpression>"
+    [[nodiscard]]
+    static std::vector<TEntry> hottest_subexpressions(size_t limit = 10);
+
+    // both of the above as a printable table
+    [[nodiscard]]
+    static std::string report(size_t limit = 10);
+
+    static void reset();
+};
+
+#endif // __EVAL_PROFILE_H__
@@ -0,0 +1,56 @@
+#ifndef __GENERATOR_H__
+#define __GENERATOR_H__
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+struct TGeneratorOptions {
+    // approximate length of the postfix program
+    size_t tokens = 100;
+    // deepest nesting of brackets and calls
+    size_t max_depth = 16;
+
+    // binary operators to pick from, repeat one to make it more frequent
+    std::string operators = "+-*/";
+    // variables are named v0, v1, ...; with none every operand is a number
+    size_t variables = 8;
+    // called functions, by default the built-in ones
+    std::vector<std::string> functions = { "sin", "cos", "sqrt" };
+
+    // chances for an operand to be one of the following rather than a
+    // variable; the rest of the time it is a variable
+    double number_density = 0.3;
+    double call_density = 0.1;
+    double bracket_density = 0.2;
+    // chance of a unary minus at the beginning of a group
+    double unary_minus = 0.05;
+    // chance of closing an open group after an operand
+    double close_density = 0.3;
+};
+
+// Seeded generator of random infix expressions that validate_infix accepts.
+// Works iteratively, so arbitrarily long expressions can be generated
+class TExpressionGenerator {
+private:
+    TGeneratorOptions options;
+    std::mt19937_64 rng;
+
+    bool chance(double probability);
+    size_t pick(size_t count);
+
+    void append_number(std::string& infix);
+public:
+    explicit TExpressionGenerator(TGeneratorOptions options = {}, uint64_t seed = 42);
+
+    [[nodiscard]]
+    std::string next();
+
+    [[nodiscard]]
+    static std::string variable_name(size_t idx);
+    [[nodiscard]]
+    std::vector<std::string> variable_names() const;
+};
+
+#endif // __GENERATOR_H__
@@ -0,0 +1,61 @@
+#ifndef __IMAGE_H__
+#define __IMAGE_H__
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "postfix.h"
+
+class expression_image_error : public std::runtime_error
+{
+public:
+    explicit
+    expression_image_error(const std::string &message)
+        : runtime_error(message)
+    {}
+};
+
+// Binary image of compiled expressions, restored without parsing or validation.
+//
+// All integers are little-endian, doubles are IEEE-754 binary64 stored as their bit pattern.
+//   header:  "PFXI", u32 version, u32 entry count, u32 reserved, u64 FNV-1a of the header
+//            before the checksum followed by everything after the header (version 2 and
+//            older only checksummed what follows the header)
+//   entry:   u32 size of the rest of the entry, u32 name length, u32 infix length, name, infix,
+//            then the version specific part:
+//            u32 string count, strings as (u32 length, bytes),
+//            u32 variable count, u32 string indexes, u32 function count, u32 string indexes,
+//            u32 token count, padding up to 8 bytes, 16 byte tokens laid out as TPostfixToken:
+//            u8 kind, 3 zero bytes, u32 position, then an 8 byte payload of either
+//            f64 literal, u32 string index of the name or u8 operator symbol
+// The entry prefix up to the infix never changes between versions, so images
+// written by another version are recompiled from their infix instead
+class TExpressionImage {
+public:
+    static constexpr uint32_t VERSION = 3;
+
+    struct TEntry {
+        std::string name;
+        std::shared_ptr<const TArithmeticExpression> expression;
+    };
+
+    TExpressionImage() = delete;
+
+    [[nodiscard]]
+    static std::string encode(const std::vector<TEntry>& entries);
+
+    // Throws expression_image_error on malformed or corrupted images.
+    // recompiled is set when the image was written by another version
+    [[nodiscard]]
+    static std::vector<TEntry> decode(std::string_view image, bool* recompiled = nullptr);
+
+    [[nodiscard]]
+    static std::string encode(const TArithmeticExpression& expression);
+    [[nodiscard]]
+    static TArithmeticExpression decode_single(std::string_view image);
+};
+
+#endif // __IMAGE_H__
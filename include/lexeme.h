@@ -30,6 +30,8 @@ struct TLexeme {
         Bracket
     } type;
     TLexemeValue value = TLexemeValue("");
+    // 1-based position in the infix, 0 for lexemes the compiler made up
+    size_t pos = 0;
 };
 
 #endif // __LEXEME_H__
@@ -1,52 +1,208 @@
 #ifndef __LIST_H__
 #define __LIST_H__
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <new>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 
+// Called on every heap allocation of any list when set, e.g. to count them
+// (instrumented builds do, see compile_stats.h)
+inline void (*list_allocation_hook)() noexcept = nullptr;
+
+// Room for the first N elements inside the list object itself
+template<class T, size_t N>
+struct TListInlineStorage {
+    alignas(T) unsigned char bytes[N * sizeof(T)];
+
+    T* data() noexcept
+    {
+        return reinterpret_cast<T*>(bytes);
+    }
+    const T* data() const noexcept
+    {
+        return reinterpret_cast<const T*>(bytes);
+    }
+};
 template<class T>
-class TDynamicList {
+struct TListInlineStorage<T, 0> {
+    T* data() noexcept
+    {
+        return nullptr;
+    }
+    const T* data() const noexcept
+    {
+        return nullptr;
+    }
+};
+
+// Elements live in raw storage and are constructed in place, so growth moves
+// them instead of default-constructing and copying. Trivially copyable
+// elements are relocated with memcpy.
+// With N > 0 the first N elements are kept inline and the heap is only
+// touched once the list outgrows them.
+// Storage comes from the given memory resource (e.g. an arena) if there is
+// one, otherwise from the global operator new. Copies never share the
+// resource of the source
+template<class T, size_t N = 0>
+class TDynamicList : private TListInlineStorage<T, N> {
 private:
+    static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned elements are not supported");
+
+    static constexpr bool RELOCATABLE = std::is_trivially_copyable_v<T>;
+
     T *pMem;
     size_t capacity;
     size_t length;
 
+    std::pmr::memory_resource *resource;
+
+    T* allocate(size_t count) const
+    {
+        if (list_allocation_hook != nullptr)
+            list_allocation_hook();
+        if (resource != nullptr)
+            return static_cast<T*>(resource->allocate(count * sizeof(T), alignof(T)));
+
+        return static_cast<T*>(::operator new(count * sizeof(T)));
+    }
+    void deallocate(T *memory, size_t count) const noexcept
+    {
+        // lists without inline storage are left without memory when moved from
+        if (memory == nullptr)
+            return;
+        if (resource != nullptr)
+            resource->deallocate(memory, count * sizeof(T), alignof(T));
+        else
+            ::operator delete(memory);
+    }
+
+    [[nodiscard]]
+    bool is_inline() const noexcept
+    {
+        return N > 0 && pMem == TListInlineStorage<T, N>::data();
+    }
+
+    void init_storage(size_t count)
+    {
+        if (count <= N)
+        {
+            pMem = TListInlineStorage<T, N>::data();
+            capacity = N;
+        }
+        else
+        {
+            pMem = allocate(count);
+            capacity = count;
+        }
+    }
+
+    // leaves the list without storage, to be followed by init_storage or take
+    void release() noexcept
+    {
+        std::destroy(pMem, pMem + length);
+        if (!is_inline())
+            deallocate(pMem, capacity);
+        length = 0;
+    }
+
+    // the list has to be without storage
+    void take(TDynamicList& src) noexcept
+    {
+        resource = src.resource;
+        if (src.is_inline())
+        {
+            init_storage(0);
+            for (size_t i = 0; i < src.length; i++)
+            {
+                new (pMem + i) T(std::move(src.pMem[i]));
+            }
+            length = src.length;
+            src.clear();
+        }
+        else
+        {
+            pMem = src.pMem;
+            capacity = src.capacity;
+            length = src.length;
+
+            src.init_storage(0);
+            src.length = 0;
+        }
+    }
+
+    void relocate(size_t new_capacity)
+    {
+        if (new_capacity <= N && is_inline())
+            return;
+
+        T *old = pMem;
+        const size_t old_capacity = capacity;
+        const bool old_inline = is_inline();
+        init_storage(new_capacity);
+        if constexpr (RELOCATABLE)
+        {
+            if (length > 0)
+                std::memcpy(static_cast<void*>(pMem), old, length * sizeof(T));
+        }
+        else
+        {
+            for (size_t i = 0; i < length; i++)
+            {
+                new (pMem + i) T(std::move_if_noexcept(old[i]));
+            }
+            std::destroy(old, old + length);
+        }
+        if (!old_inline)
+            deallocate(old, old_capacity);
+    }
+
     void expand_if_needed()
     {
         if (length < capacity) return;
 
-        //
-        const size_t new_capacity = capacity * 2;
-        //
-
-        capacity = new_capacity;
-        TDynamicList<T> tmp(*this);
-        swap(*this, tmp);
+        relocate(std::max<size_t>(capacity * 2, 1));
     }
 public:
     explicit
-    TDynamicList(size_t initial_capacity = 8)
-            : capacity(initial_capacity > 0
-                ? initial_capacity
-                : throw std::invalid_argument("Initial list capacity should be greater than 0"))
+    TDynamicList(size_t initial_capacity = N > 0 ? N : 8, std::pmr::memory_resource *resource = nullptr)
+            : pMem(nullptr)
+            , capacity(0)
             , length(0)
-            , pMem(new T[initial_capacity])
-    {}
+            , resource(resource)
+    {
+        if (initial_capacity == 0)
+            throw std::invalid_argument("Initial list capacity should be greater than 0");
+
+        init_storage(initial_capacity);
+    }
     TDynamicList(const TDynamicList& src)
-            : capacity(src.capacity)
-            , length(src.length)
-            , pMem(new T[src.capacity])
+            : pMem(nullptr)
+            , capacity(0)
+            , length(0)
+            , resource(nullptr)
     {
-        std::copy(src.pMem, src.pMem + length, pMem);
+        init_storage(src.capacity);
+        std::uninitialized_copy(src.pMem, src.pMem + src.length, pMem);
+        length = src.length;
     }
     TDynamicList(TDynamicList&& src) noexcept
             : pMem(nullptr)
+            , capacity(0)
+            , length(0)
+            , resource(nullptr)
     {
-        swap(*this, src);
+        take(src);
     }
 
     ~TDynamicList()
     {
-        delete[] pMem;
+        release();
     }
 
     T* begin() const
@@ -64,38 +220,86 @@ public:
         return length;
     }
 
+    [[nodiscard]]
+    size_t get_capacity() const noexcept
+    {
+        return capacity;
+    }
+
+    // null for the global operator new
+    [[nodiscard]]
+    std::pmr::memory_resource* get_resource() const noexcept
+    {
+        return resource;
+    }
+
+    // heap bytes held by the list, zero while the elements fit inline
+    [[nodiscard]]
+    size_t allocated_bytes() const noexcept
+    {
+        return is_inline() ? 0 : capacity * sizeof(T);
+    }
+
     [[nodiscard]]
     bool empty() const noexcept
     {
         return length == 0;
     }
 
+    void reserve(size_t new_capacity)
+    {
+        if (new_capacity > capacity)
+            relocate(new_capacity);
+    }
+
+    template<class... Args>
+    T& emplace_back(Args&&... args)
+    {
+        if (length < capacity)
+        {
+            new (pMem + length) T(std::forward<Args>(args)...);
+        }
+        else
+        {
+            // the arguments may refer to an element of this very list
+            T element(std::forward<Args>(args)...);
+            expand_if_needed();
+            new (pMem + length) T(std::move(element));
+        }
+        return pMem[length++];
+    }
+
     void push_back(const T& element)
     {
-        expand_if_needed();
-        pMem[length++] = element;
+        emplace_back(element);
     }
     void push_back(T&& element)
     {
-        push_back(element);
+        emplace_back(std::move(element));
     }
 
     void insert(size_t idx, const T& element)
     {
-        expand_if_needed();
-        std::copy(pMem + idx, pMem + length, pMem + idx + 1);
-        pMem[idx] = element;
-        length++;
+        insert(idx, T(element));
     }
     void insert(size_t idx, T&& element)
     {
-        insert(idx, element);
+        if (idx == length)
+        {
+            emplace_back(std::move(element));
+            return;
+        }
+
+        emplace_back(std::move(pMem[length - 1]));
+        std::move_backward(pMem + idx, pMem + length - 2, pMem + length - 1);
+        pMem[idx] = std::move(element);
     }
 
     void remove(size_t idx)
     {
-        std::copy(pMem + idx + 1, pMem + length, pMem + idx);
+        std::move(pMem + idx + 1, pMem + length, pMem + idx);
         length--;
+        std::destroy_at(pMem + length);
     }
 
     T& tail()
@@ -133,33 +337,93 @@ public:
         if (this == &other)
             return *this;
 
-        TDynamicList<T> tmp(other);
+        TDynamicList tmp(other);
         swap(*this, tmp);
         return *this;
     }
     TDynamicList& operator=(TDynamicList&& other) noexcept
     {
-        swap(*this, other);
+        if (this == &other)
+            return *this;
+
+        release();
+        take(other);
         return *this;
     }
 
     void clear()
     {
+        std::destroy(pMem, pMem + length);
         length = 0;
     }
 
     void shrink_to_fit()
     {
-        capacity = length;
-        TDynamicList<T> tmp(*this);
-        swap(*this, tmp);
+        relocate(std::max<size_t>(length, 1));
     }
 
     friend void swap(TDynamicList& lhs, TDynamicList& rhs) noexcept
     {
+        if (lhs.is_inline() || rhs.is_inline())
+        {
+            TDynamicList tmp(std::move(lhs));
+            lhs = std::move(rhs);
+            rhs = std::move(tmp);
+            return;
+        }
+
         std::swap(lhs.pMem, rhs.pMem);
         std::swap(lhs.capacity, rhs.capacity);
         std::swap(lhs.length, rhs.length);
+        std::swap(lhs.resource, rhs.resource);
+    }
+};
+
+// Read-only view of contiguous elements owned by someone else
+template<class T>
+class TListView {
+private:
+    const T *first;
+    const T *last;
+public:
+    TListView(const T *first, const T *last) noexcept
+            : first(first)
+            , last(last)
+    {}
+
+    const T* begin() const noexcept
+    {
+        return first;
+    }
+    const T* end() const noexcept
+    {
+        return last;
+    }
+
+    [[nodiscard]]
+    size_t size() const noexcept
+    {
+        return last - first;
+    }
+
+    [[nodiscard]]
+    bool empty() const noexcept
+    {
+        return first == last;
+    }
+
+    const T& operator[](const size_t idx) const
+    {
+        return first[idx];
+    }
+
+    bool operator==(const TListView& other) const
+    {
+        return std::equal(first, last, other.first, other.last);
+    }
+    bool operator!=(const TListView& other) const
+    {
+        return !(*this == other);
     }
 };
 
@@ -0,0 +1,72 @@
+#ifndef __MAPPED_FILE_H__
+#define __MAPPED_FILE_H__
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only view of a whole file mapped into memory.
+// Falls back to reading the file into a buffer where mmap is not available
+class TMappedFile {
+private:
+    const char* pData = nullptr;
+    size_t length = 0;
+
+    void* handle = nullptr;
+
+    void release() noexcept;
+public:
+    TMappedFile() = default;
+    explicit TMappedFile(const std::string& path);
+
+    TMappedFile(const TMappedFile&) = delete;
+    TMappedFile& operator=(const TMappedFile&) = delete;
+
+    TMappedFile(TMappedFile&& src) noexcept;
+    TMappedFile& operator=(TMappedFile&& src) noexcept;
+
+    ~TMappedFile();
+
+    [[nodiscard]] const char* data() const noexcept { return pData; }
+    [[nodiscard]] size_t size() const noexcept { return length; }
+
+    [[nodiscard]]
+    std::string_view view() const noexcept
+    {
+        return { pData, length };
+    }
+};
+
+// Writable file of a fixed size mapped into memory, whatever is written to
+// data() ends up in the file. Falls back to a buffer written out by close()
+// where mmap is not available
+class TMappedOutputFile {
+private:
+    char* pData = nullptr;
+    size_t length = 0;
+
+    void* handle = nullptr;
+    std::string path;
+
+    void release() noexcept;
+public:
+    TMappedOutputFile() = default;
+    // creates or truncates the file
+    TMappedOutputFile(const std::string& path, size_t size);
+
+    TMappedOutputFile(const TMappedOutputFile&) = delete;
+    TMappedOutputFile& operator=(const TMappedOutputFile&) = delete;
+
+    TMappedOutputFile(TMappedOutputFile&& src) noexcept;
+    TMappedOutputFile& operator=(TMappedOutputFile&& src) noexcept;
+
+    // closes the file, ignoring failures; call close() to see them
+    ~TMappedOutputFile();
+
+    void close();
+
+    [[nodiscard]] char* data() const noexcept { return pData; }
+    [[nodiscard]] size_t size() const noexcept { return length; }
+};
+
+#endif // __MAPPED_FILE_H__
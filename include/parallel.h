@@ -0,0 +1,61 @@
+#ifndef __PARALLEL_H__
+#define __PARALLEL_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads splitting index ranges between themselves.
+// The calling thread takes part in the work, so a pool of N workers runs
+// N + 1 chunks at a time
+class TThreadPool {
+private:
+    std::vector<std::thread> workers;
+
+    std::mutex submit_mutex;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    size_t generation = 0;
+    size_t active = 0;
+    bool stopping = false;
+
+    const std::function<void (size_t, size_t)>* job = nullptr;
+    size_t job_count = 0;
+    size_t job_grain = 1;
+    std::atomic<size_t> next { 0 };
+    std::exception_ptr failure;
+
+    void work();
+    void run_chunks();
+public:
+    // 0 threads means one per hardware thread, the caller included
+    explicit TThreadPool(size_t threads = 0);
+    ~TThreadPool();
+
+    TThreadPool(const TThreadPool&) = delete;
+    TThreadPool& operator=(const TThreadPool&) = delete;
+
+    // number of threads taking part in parallel_for, the caller included
+    [[nodiscard]]
+    size_t concurrency() const noexcept
+    {
+        return workers.size() + 1;
+    }
+
+    // Calls body(begin, end) over [0, count) split into chunks of at most
+    // grain indices and returns once all of them are done. The first
+    // exception thrown by the body is rethrown in the caller. Calls made
+    // from within a body run inline on the calling thread
+    void parallel_for(size_t count, size_t grain, const std::function<void (size_t, size_t)>& body);
+
+    static TThreadPool& shared();
+};
+
+#endif // __PARALLEL_H__
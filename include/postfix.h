@@ -3,12 +3,16 @@
 
 #include <stdexcept>
 #include <string>
-#include <set>
 #include <functional>
 #include <memory>
 #include <map>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
 #include "lexeme.h"
 #include "list.h"
+#include "symbols.h"
+#include "token.h"
 
 class expression_parse_error : public std::runtime_error
 {
@@ -27,7 +31,13 @@ public:
         BadNumber,
         BadOperator,
         MissingBracket,
-        ExtraBracket
+        ExtraBracket,
+        // two operands without an operator between them, like "(1)(2)"
+        MissingOperator,
+        // a call without an argument, like "f()"
+        EmptyCall,
+        // empty brackets where an operand belongs, like "1+()"
+        MissingOperand
     };
 private:
     cause m_cause;
@@ -55,28 +65,187 @@ public:
     virtual double execute(double x) = 0;
 };
 
+// Values and function implementations addressed by symbol, so evaluation
+// resolves every name with a single indexed load. Starts out with the
+// built-in constants and functions, which can be overridden
+class TExpressionBindings {
+private:
+    std::vector<double> values;
+    std::vector<bool> bound;
+    std::vector<std::shared_ptr<TArithmeticExpressionFunction>> functions;
+public:
+    TExpressionBindings();
+
+    void set(TSymbol symbol, double value);
+    void set(std::string_view name, double value);
+
+    void set_function(TSymbol symbol, std::shared_ptr<TArithmeticExpressionFunction> function);
+    void set_function(std::string_view name, std::shared_ptr<TArithmeticExpressionFunction> function);
+
+    [[nodiscard]]
+    bool has_value(TSymbol symbol) const noexcept
+    {
+        return symbol < bound.size() && bound[symbol];
+    }
+    [[nodiscard]]
+    bool has_function(TSymbol symbol) const noexcept
+    {
+        return symbol < functions.size() && functions[symbol] != nullptr;
+    }
+
+    // unchecked, the symbol has to be bound
+    [[nodiscard]]
+    double value(TSymbol symbol) const
+    {
+        return values[symbol];
+    }
+    [[nodiscard]]
+    TArithmeticExpressionFunction& function(TSymbol symbol) const
+    {
+        return *functions[symbol];
+    }
+};
+
+// Per-variable columns for evaluating one expression over many rows at once.
+// Each column points at the value of row 0 and has to hold as many values
+// as the rows evaluated; the columns are not owned. Values of a row are
+// stride doubles apart, so columns of row-major data are used in place
+class TExpressionColumns {
+public:
+    struct TColumn {
+        const double* values = nullptr;
+        size_t stride = 1;
+    };
+private:
+    std::vector<TColumn> columns;
+public:
+    void set(TSymbol symbol, const double* values, size_t stride = 1);
+    void set(std::string_view name, const double* values, size_t stride = 1);
+
+    [[nodiscard]]
+    bool has_column(TSymbol symbol) const noexcept
+    {
+        return symbol < columns.size() && columns[symbol].values != nullptr;
+    }
+
+    // unchecked, the symbol has to have a column
+    [[nodiscard]]
+    const TColumn& column(TSymbol symbol) const
+    {
+        return columns[symbol];
+    }
+};
+
+// Value built on first use and shared by copies; safe to request from
+// several threads at once
+template<class T>
+class TLazy {
+private:
+    mutable std::shared_ptr<const T> value;
+public:
+    TLazy() = default;
+    TLazy(const TLazy& other)
+        : value(std::atomic_load(&other.value))
+    {}
+    TLazy& operator=(const TLazy& other)
+    {
+        std::atomic_store(&value, std::atomic_load(&other.value));
+        return *this;
+    }
+
+    // make returns the value as std::shared_ptr<const T>, so that it is
+    // never moved once built
+    template<class Make>
+    const T& get(Make make) const
+    {
+        std::shared_ptr<const T> current = std::atomic_load(&value);
+        if (current == nullptr)
+        {
+            // a racing thread may have won, its value is then used instead
+            std::shared_ptr<const T> made = make();
+            if (std::atomic_compare_exchange_strong(&value, &current, made))
+                current = std::move(made);
+        }
+        return *current;
+    }
+
+    // null until the value has been built
+    [[nodiscard]]
+    const T* peek() const
+    {
+        return std::atomic_load(&value).get();
+    }
+};
+
+// All storage of an expression comes from the memory resource it was
+// constructed with, so a catalog compiled into one arena is laid out
+// contiguously and freed in one shot. The resource has to outlive the
+// expression; copies use the default resource
 class TArithmeticExpression {
 private:
-    const std::string infix;
-    TDynamicList<std::string> postfix;
+    const std::pmr::string infix;
+
+    TDynamicList<TPostfixToken> tokens;
+
+    // sorted symbols of the free variables and user functions
+    std::pmr::vector<TSymbol> variables;
+    std::pmr::vector<TSymbol> func_names;
+
+    // deepest evaluation stack the program needs, 0 for an empty program
+    size_t stack_depth = 0;
 
-    TDynamicList<TLexeme> tokens;
+    // Text forms, only needed for display: built from the program on first
+    // request. The views refer to the postfix text and the symbol table
+    struct TText {
+        std::string postfix;
+        std::vector<std::string_view> lexemes;
+        std::vector<std::string_view> variables;
+        std::vector<std::string_view> functions;
+    };
+    TLazy<TText> text;
+
+    [[nodiscard]] std::shared_ptr<const TText> make_text() const;
+
+    // Computes stack_depth; false if the program would underflow the stack
+    // or leave anything but a single value on it
+    bool verify_program();
+
+    friend class TExpressionCompiler;
+    friend class TExpressionImage;
 
-    std::set<std::string> variables;
-    std::set<std::string> func_names;
+    // for loaders restoring an already compiled program
+    struct restore_tag {};
+    TArithmeticExpression(restore_tag, std::string infix);
 public:
-    explicit TArithmeticExpression(const std::string& infix);
+    explicit TArithmeticExpression(std::string_view infix);
+    TArithmeticExpression(std::string_view infix, std::pmr::memory_resource* arena);
 
     [[nodiscard]] std::string get_infix() const;
-    [[nodiscard]] TDynamicList<std::string> get_postfix() const;
+    // lexemes of the postfix form; implicit operands of unary operators are empty
+    [[nodiscard]] TListView<std::string_view> get_postfix() const;
+    // the postfix form with lexemes separated by POSTFIX_LEXEME_SEPARATOR
+    [[nodiscard]] std::string_view get_postfix_text() const;
 
-    [[nodiscard]] std::set<std::string> get_variables() const;
-    [[nodiscard]] std::set<std::string> get_functions() const;
+    // names in alphabetical order
+    [[nodiscard]] TListView<std::string_view> get_variables() const;
+    [[nodiscard]] TListView<std::string_view> get_functions() const;
+
+    // bytes owned by the expression, including its heap allocations
+    [[nodiscard]] size_t memory_usage() const;
 
     [[nodiscard]]
     double calculate(
             const std::map<std::string, double>& values = {},
             const std::map<std::string, std::shared_ptr<TArithmeticExpressionFunction>>& functions = {}) const;
+    [[nodiscard]]
+    double calculate(const TExpressionBindings& bindings) const;
+
+    // Evaluates rows [0, rows) into results. Variables with a column take
+    // the value of the row, the others come from the bindings. Runs each
+    // operation over a block of rows at a time, so the cost of dispatching
+    // the program is shared by the block
+    void calculate_batch(const TExpressionBindings& bindings, const TExpressionColumns& columns,
+                         size_t rows, double* results) const;
 
     static const char POSTFIX_LEXEME_SEPARATOR = ' ';
 };
@@ -0,0 +1,58 @@
+#ifndef __REGISTRY_H__
+#define __REGISTRY_H__
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "postfix.h"
+#include "parallel.h"
+
+// Catalog of compiled formulas loaded from text: one expression per line,
+// optionally named as 'name = expression'. Blank lines are skipped
+class TFormulaRegistry {
+public:
+    struct TEntry {
+        std::string name;
+        // 0 for entries restored from an image
+        size_t line;
+        std::shared_ptr<const TArithmeticExpression> expression;
+    };
+
+    struct TError {
+        size_t line;
+        size_t column;
+        std::string message;
+        expression_validation_error::cause cause;
+    };
+private:
+    std::vector<TEntry> entries;
+    std::vector<TError> errors;
+    std::unordered_map<std::string, size_t> index;
+public:
+    // Maps the file and compiles its formulas on the pool
+    [[nodiscard]]
+    static TFormulaRegistry load(const std::string& path, TThreadPool& pool = TThreadPool::shared());
+
+    [[nodiscard]]
+    static TFormulaRegistry parse(std::string_view text, TThreadPool& pool = TThreadPool::shared());
+
+    // Binary snapshot of the compiled formulas (see TExpressionImage) for instant startup.
+    // Images written by another library version are recompiled from their infix
+    void save_image(const std::string& path) const;
+    [[nodiscard]]
+    static TFormulaRegistry load_image(const std::string& path);
+
+    // nullptr if there is no successfully compiled formula with the name
+    [[nodiscard]]
+    std::shared_ptr<const TArithmeticExpression> find(const std::string& name) const;
+
+    // successfully compiled formulas in file order
+    [[nodiscard]] const std::vector<TEntry>& get_entries() const noexcept { return entries; }
+    [[nodiscard]] const std::vector<TError>& get_errors() const noexcept { return errors; }
+
+    [[nodiscard]] size_t size() const noexcept { return entries.size(); }
+};
+
+#endif // __REGISTRY_H__
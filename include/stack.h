@@ -2,47 +2,36 @@
 #define __STACK_H__
 
 #include "list.h"
+#include <cassert>
+#include <memory>
 #include <stdexcept>
 
-#define _STACK_STR(x) #x
-#define _STACK_EXPAND(x) _STACK_STR(x)
-
-const size_t MAX_STACK_SIZE = 1000;
-
-template<typename T>
+// N elements are kept inside the stack object, see TDynamicList
+template<typename T, size_t N = 0>
 class TStack
 {
 private:
-    TDynamicList<T> list;
+    TDynamicList<T, N> list;
 
     void require_not_empty() const
     {
         if (empty())
             throw std::logic_error("Stack is empty");
     }
-
-    void ensure_space_sufficient() const
-    {
-        if (size() == MAX_STACK_SIZE)
-            throw std::length_error("Stack overflow");
-    }
 public:
+    // the stack grows on demand, the capacity only saves reallocations
     explicit
-    TStack(size_t initial_capacity = 8)
-        : list(initial_capacity <= MAX_STACK_SIZE
-            ? initial_capacity
-            : throw std::out_of_range("Stack size cannot exceed " _STACK_EXPAND(MAX_STACK_SIZE)))
+    TStack(size_t initial_capacity = N > 0 ? N : 8, std::pmr::memory_resource *resource = nullptr)
+        : list(initial_capacity, resource)
     {}
 
     void push(const T& element)
     {
-        ensure_space_sufficient();
         list.push_back(element);
     }
     void push(T&& element)
     {
-        ensure_space_sufficient();
-        list.push_back(element);
+        list.push_back(std::move(element));
     }
 
     T& top()
@@ -62,7 +51,7 @@ public:
     {
         require_not_empty();
 
-        T element = list[list.size() - 1];
+        T element = std::move(list.tail());
         list.remove(list.size() - 1);
         return element;
     }
@@ -83,7 +72,78 @@ public:
     }
 };
 
-#undef _STACK_EXPAND
-#undef _STACK_STR
+// Stack for programs whose stack use has been verified beforehand: the
+// capacity is fixed at construction and the operations are only checked by
+// assertions in debug builds. Up to N elements are kept inline.
+// Storage is left uninitialized until pushed to, so elements have to be
+// trivially copyable
+template<typename T, size_t N = 32>
+class TUncheckedStack : private TListInlineStorage<T, N>
+{
+private:
+    static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>,
+                  "elements are not constructed or destroyed");
+    static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "over-aligned elements are not supported");
+
+    T *heap_items = nullptr;
+    T *items;
+
+    size_t count = 0;
+    size_t capacity;
+public:
+    explicit
+    TUncheckedStack(size_t capacity)
+        : items(TListInlineStorage<T, N>::data())
+        , capacity(capacity)
+    {
+        if (capacity > N)
+        {
+            heap_items = static_cast<T*>(::operator new(capacity * sizeof(T)));
+            items = heap_items;
+        }
+    }
+    ~TUncheckedStack()
+    {
+        ::operator delete(heap_items);
+    }
+
+    TUncheckedStack(const TUncheckedStack&) = delete;
+    TUncheckedStack& operator=(const TUncheckedStack&) = delete;
+
+    void push(const T& element)
+    {
+        assert(count < capacity);
+        new (items + count++) T(element);
+    }
+
+    T& top()
+    {
+        assert(count > 0);
+        return items[count - 1];
+    }
+
+    void pop()
+    {
+        assert(count > 0);
+        count--;
+    }
+
+    [[nodiscard]]
+    T pop_element()
+    {
+        assert(count > 0);
+        return items[--count];
+    }
+
+    bool empty() const noexcept
+    {
+        return count == 0;
+    }
+
+    size_t size() const noexcept
+    {
+        return count;
+    }
+};
 
 #endif // __STACK_H__
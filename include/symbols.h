@@ -0,0 +1,45 @@
+#ifndef __SYMBOLS_H__
+#define __SYMBOLS_H__
+
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Identifier interned by TSymbolTable, a small dense index
+using TSymbol = uint32_t;
+
+// Thread-safe table mapping variable and function names to dense ids.
+// Ids are never reused and names stay valid for the lifetime of the table
+class TSymbolTable {
+private:
+    mutable std::shared_mutex mutex;
+
+    // deque keeps the names in place, so the index can refer to them
+    std::deque<std::string> names;
+    std::unordered_map<std::string_view, TSymbol> index;
+public:
+    static constexpr TSymbol NONE = UINT32_MAX;
+
+    TSymbolTable() = default;
+    TSymbolTable(const TSymbolTable&) = delete;
+    TSymbolTable& operator=(const TSymbolTable&) = delete;
+
+    TSymbol intern(std::string_view name);
+
+    // NONE if the name has never been interned
+    [[nodiscard]]
+    TSymbol find(std::string_view name) const;
+
+    [[nodiscard]]
+    const std::string& name(TSymbol symbol) const;
+
+    [[nodiscard]]
+    size_t size() const;
+
+    static TSymbolTable& global();
+};
+
+#endif // __SYMBOLS_H__
@@ -0,0 +1,52 @@
+#ifndef __TOKEN_H__
+#define __TOKEN_H__
+
+#include <cstdint>
+#include <string>
+#include "symbols.h"
+
+// Element of a compiled postfix program. Packed into 16 bytes, so four
+// tokens share a cache line and the program holds no pointers at all
+struct TPostfixToken {
+    enum class Kind : uint8_t {
+        Number,
+        Variable,
+        Function,
+        Operator
+    };
+
+    Kind kind;
+    uint8_t reserved[3];
+
+    // 1-based position of the lexeme in the infix, 0 for implicit operands
+    uint32_t pos;
+
+    union {
+        double number;
+        TSymbol symbol;
+        char op;
+    };
+
+    static TPostfixToken make_number(double number, uint32_t pos = 0)
+    {
+        TPostfixToken token = { Kind::Number, {}, pos, {} };
+        token.number = number;
+        return token;
+    }
+    static TPostfixToken make_symbol(Kind kind, TSymbol symbol, uint32_t pos = 0)
+    {
+        TPostfixToken token = { kind, {}, pos, {} };
+        token.symbol = symbol;
+        return token;
+    }
+    static TPostfixToken make_operator(char op, uint32_t pos = 0)
+    {
+        TPostfixToken token = { Kind::Operator, {}, pos, {} };
+        token.op = op;
+        return token;
+    }
+};
+
+static_assert(sizeof(TPostfixToken) == 16, "Postfix tokens should stay 16 bytes long");
+
+#endif // __TOKEN_H__
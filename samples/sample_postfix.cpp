@@ -1,29 +1,12 @@
 ﻿#include <iostream>
 #include <string>
-#include <sstream>
 #include "postfix.h"
 
 using namespace std;
 
-string get_postfix_as_string(const TArithmeticExpression& expr)
-{
-    const auto& postfix = expr.get_postfix();
-    const size_t size = postfix.size();
-
-    stringstream ss;
-    for (size_t i = 0; i < size - 1; i++)
-    {
-        ss << postfix[i] << ' ';
-    }
-    ss << postfix[size - 1];
-
-    return ss.str();
-}
-
 int main()
 {
     setlocale(LC_ALL, "Russian");
-    setlocale(LC_NUMERIC, "en_US.UTF-8");
     /////
 
     string infix;
@@ -41,7 +24,7 @@ int main()
         return EXIT_FAILURE;
     }
     cout << "Арифметическое выражение: " << expr->get_infix() << endl;
-    cout << "Постфиксная форма: '" << get_postfix_as_string(*expr) << "'" << endl;
+    cout << "Постфиксная форма: '" << expr->get_postfix_text() << "'" << endl;
     cout << endl;
 
     auto variables = expr->get_variables();
@@ -49,7 +32,7 @@ int main()
     for (const auto& var : variables)
     {
         cout << " Введите значение для '" << var << "': ";
-        cin >> values[var];
+        cin >> values[string(var)];
     }
     //
     auto func_names = expr->get_functions();
@@ -58,7 +41,7 @@ int main()
     {
         cout << " Введите формулу для '" << fun << "(x)': ";
         cin >> infix;
-        functions[fun] = std::make_shared<TExplicitArithmeticExpressionFunction>(TArithmeticExpression(infix));
+        functions[string(fun)] = std::make_shared<TExplicitArithmeticExpressionFunction>(TArithmeticExpression(infix));
     }
     cout << endl;
 
@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "server_protocol.h"
+
+using namespace std;
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using clock_type = chrono::steady_clock;
+
+static void usage()
+{
+    cerr << "usage: sample_postfix_client SOCKET FORMULA [--connections=C] [--requests=N] [--pipeline=P]" << endl
+         << "  Evaluates FORMULA on sample_postfix_server with random values over C connections" << endl
+         << "  (default 4), N requests each (default 100000), keeping up to P requests in flight" << endl
+         << "  per connection (default 16), and reports the throughput and latencies." << endl;
+}
+
+// a blocking connection exchanging whole frames
+class TClient {
+private:
+    int fd = -1;
+    string input;
+    size_t consumed = 0;
+public:
+    explicit TClient(const string& path)
+    {
+        sockaddr_un address {};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path))
+            throw runtime_error("socket path is too long");
+        memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, (const sockaddr*)&address, sizeof(address)) != 0)
+            throw runtime_error("cannot connect to " + path + ": " + strerror(errno));
+    }
+    ~TClient()
+    {
+        if (fd >= 0)
+            ::close(fd);
+    }
+
+    TClient(const TClient&) = delete;
+    TClient& operator=(const TClient&) = delete;
+
+    void send(string_view data)
+    {
+        while (!data.empty())
+        {
+            const ssize_t written = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written <= 0)
+                throw runtime_error(string("send failed: ") + strerror(errno));
+            data.remove_prefix((size_t)written);
+        }
+    }
+
+    // the frame stays valid until the next call
+    Protocol::TFrame receive()
+    {
+        input.erase(0, consumed);
+        consumed = 0;
+
+        Protocol::TFrame frame;
+        while ((consumed = Protocol::next_frame(input, frame)) == 0)
+        {
+            char buffer[64 * 1024];
+            const ssize_t received = ::read(fd, buffer, sizeof(buffer));
+            if (received < 0 && errno == EINTR)
+                continue;
+            if (received <= 0)
+                throw runtime_error("connection closed by the server");
+            input.append(buffer, (size_t)received);
+        }
+        return frame;
+    }
+};
+
+struct TFormulaInfo {
+    uint32_t id;
+    size_t variables;
+};
+
+static TFormulaInfo lookup(TClient& client, const string& formula)
+{
+    string request;
+    const size_t start = Protocol::begin_frame(request, (uint8_t)Protocol::Type::Lookup, 0);
+    request += formula;
+    Protocol::finish_frame(request, start);
+    client.send(request);
+
+    const Protocol::TFrame reply = client.receive();
+    if ((Protocol::Status)reply.type != Protocol::Status::Ok)
+        throw runtime_error(string(reply.body));
+    return { Protocol::read<uint32_t>(reply.body.data()), Protocol::read<uint16_t>(reply.body.data() + 4) };
+}
+
+struct TResults {
+    vector<double> latencies;
+    size_t errors = 0;
+};
+
+static void run(const string& path, const string& formula, size_t requests, size_t pipeline, unsigned seed,
+                TResults& results)
+{
+    TClient client(path);
+    const TFormulaInfo info = lookup(client, formula);
+
+    mt19937_64 random(seed);
+    uniform_real_distribution<double> values(1, 100);
+
+    deque<clock_type::time_point> in_flight;
+    string batch;
+    size_t sent = 0;
+    size_t received = 0;
+    results.latencies.reserve(requests);
+    while (received < requests)
+    {
+        // top the pipeline up with a single write
+        batch.clear();
+        while (sent < requests && in_flight.size() < pipeline)
+        {
+            const size_t start = Protocol::begin_frame(batch, (uint8_t)Protocol::Type::Evaluate, (uint32_t)sent);
+            Protocol::append<uint32_t>(batch, info.id);
+            for (size_t v = 0; v < info.variables; v++)
+            {
+                Protocol::append<double>(batch, values(random));
+            }
+            Protocol::finish_frame(batch, start);
+            in_flight.push_back(clock_type::now());
+            sent++;
+        }
+        client.send(batch);
+
+        // replies come in request order
+        const Protocol::TFrame reply = client.receive();
+        if ((Protocol::Status)reply.type != Protocol::Status::Ok)
+            results.errors++;
+        results.latencies.push_back(chrono::duration<double>(clock_type::now() - in_flight.front()).count());
+        in_flight.pop_front();
+        received++;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t connections = 4;
+    size_t requests = 100000;
+    size_t pipeline = 16;
+    vector<string> arguments;
+    bool bad_arguments = false;
+    for (int i = 1; i < argc; i++)
+    {
+        const string_view arg = argv[i];
+        if (arg.substr(0, 14) == "--connections=")
+            connections = stoul(string(arg.substr(14)));
+        else if (arg.substr(0, 11) == "--requests=")
+            requests = stoul(string(arg.substr(11)));
+        else if (arg.substr(0, 11) == "--pipeline=")
+            pipeline = max<size_t>(1, stoul(string(arg.substr(11))));
+        else if (arg.substr(0, 2) != "--")
+            arguments.emplace_back(arg);
+        else
+            bad_arguments = true;
+    }
+    if (bad_arguments || arguments.size() != 2 || connections == 0)
+    {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    vector<TResults> results(connections);
+    vector<string> failures(connections);
+    const auto start = clock_type::now();
+    {
+        vector<thread> threads;
+        for (size_t c = 0; c < connections; c++)
+        {
+            threads.emplace_back([&, c]() {
+                try {
+                    run(arguments[0], arguments[1], requests, pipeline, (unsigned)c, results[c]);
+                } catch (const exception& err) {
+                    failures[c] = err.what();
+                }
+            });
+        }
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+    }
+    const double seconds = chrono::duration<double>(clock_type::now() - start).count();
+
+    for (const auto& failure : failures)
+    {
+        if (!failure.empty())
+        {
+            cerr << "error: " << failure << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    vector<double> latencies;
+    size_t errors = 0;
+    for (const auto& result : results)
+    {
+        latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+        errors += result.errors;
+    }
+    sort(latencies.begin(), latencies.end());
+    const auto percentile = [&latencies](double p) {
+        return latencies.empty() ? 0.0 : latencies[min(latencies.size() - 1, (size_t)(p * latencies.size()))] * 1e6;
+    };
+
+    cout << latencies.size() << " requests in " << seconds << " s, "
+         << (size_t)(latencies.size() / seconds) << " requests/s, " << errors << " errors" << endl
+         << "latency us: p50 " << percentile(0.5) << ", p99 " << percentile(0.99)
+         << ", max " << percentile(1.0) << endl;
+    return EXIT_SUCCESS;
+}
+
+#else
+
+int main()
+{
+    cerr << "sample_postfix_client needs Unix domain sockets" << endl;
+    return EXIT_FAILURE;
+}
+
+#endif
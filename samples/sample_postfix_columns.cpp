@@ -0,0 +1,83 @@
+#include <charconv>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "postfix.h"
+#include "column_file.h"
+
+using namespace std;
+
+static void usage()
+{
+    cerr << "usage: sample_postfix_columns EXPRESSION --output=FILE [NAME=FILE ...] [FILE ...] [--threads=N]" << endl
+         << "  Evaluates EXPRESSION over packed little-endian doubles without parsing or copying." << endl
+         << "  NAME=FILE  a raw column file holding the values of variable NAME" << endl
+         << "  FILE       an interleaved column file, whose header names its columns" << endl
+         << "  The results are written as a raw column file to the output." << endl
+         << "  --threads=N  evaluate on N threads, 0 (default) for all hardware threads" << endl;
+}
+
+int main(int argc, char** argv)
+{
+    string output_path;
+    size_t threads = 0;
+    vector<string> arguments;
+    bool bad_arguments = false;
+    for (int i = 1; i < argc; i++)
+    {
+        const string_view arg = argv[i];
+        if (arg.substr(0, 9) == "--output=")
+            output_path = string(arg.substr(9));
+        else if (arg.substr(0, 10) == "--threads=")
+        {
+            const string_view count = arg.substr(10);
+            const auto parsed = from_chars(count.data(), count.data() + count.size(), threads);
+            if (parsed.ec != errc() || parsed.ptr != count.data() + count.size())
+                bad_arguments = true;
+        }
+        else if (arg.substr(0, 2) != "--")
+            arguments.emplace_back(arg);
+        else
+            bad_arguments = true;
+    }
+    if (bad_arguments || arguments.size() < 2 || output_path.empty())
+    {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    try {
+        const TArithmeticExpression expression(arguments[0]);
+
+        vector<TColumnFile> files;
+        for (size_t i = 1; i < arguments.size(); i++)
+        {
+            const string& arg = arguments[i];
+            const size_t eq = arg.find('=');
+            if (eq != string::npos)
+                files.push_back(TColumnFile::open_raw(arg.substr(eq + 1), arg.substr(0, eq)));
+            else
+                files.push_back(TColumnFile::open_interleaved(arg));
+        }
+
+        vector<const TColumnFile*> inputs;
+        for (const auto& file : files)
+        {
+            inputs.push_back(&file);
+        }
+
+        const auto start = chrono::steady_clock::now();
+        TThreadPool pool(threads);
+        const size_t rows = evaluate_column_files(expression, TExpressionBindings(), inputs, output_path, pool);
+        const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        cerr << rows << " rows in " << seconds << " s" << endl;
+    } catch (const exception& err) {
+        cerr << "error: " << err.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
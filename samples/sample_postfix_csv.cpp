@@ -0,0 +1,299 @@
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "postfix.h"
+#include "parallel.h"
+#include "mapped_file.h"
+
+using namespace std;
+
+// rows are parsed and evaluated in blocks of this many, per thread
+static const size_t BLOCK_ROWS = 4096;
+// the file is split into chunks of about this size at row boundaries
+static const size_t CHUNK_BYTES = 8 << 20;
+// fields that do not parse are listed up to this many, then only counted
+static const size_t MAX_REPORTED = 10;
+
+static void usage()
+{
+    cerr << "usage: sample_postfix_csv EXPRESSION FILE [--output=FILE] [--name=COLUMN] [--threads=N]" << endl
+         << "  Evaluates EXPRESSION for every row of the comma separated FILE, whose" << endl
+         << "  header names the variables, and writes the results as a single column" << endl
+         << "  named COLUMN ('result' by default) to stdout or the output file." << endl
+         << "  Fields are plain numbers, quoting is not supported; fields that are" << endl
+         << "  missing or do not parse evaluate as nan, and the ones that do not parse" << endl
+         << "  are reported on stderr." << endl
+         << "  --threads=N  parse and evaluate on N threads, 0 (default) for all hardware threads" << endl;
+}
+
+static string_view trim(string_view s)
+{
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+        s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r'))
+        s.remove_suffix(1);
+    return s;
+}
+
+// position of each CSV column among the expression variables, -1 for unused columns
+static vector<int> map_columns(string_view header, const TListView<string_view>& variables)
+{
+    vector<int> slots;
+    vector<bool> found(variables.size());
+    size_t start = 0;
+    while (start <= header.size())
+    {
+        size_t end = header.find(',', start);
+        if (end == string_view::npos)
+            end = header.size();
+
+        const string_view name = trim(header.substr(start, end - start));
+        int slot = -1;
+        for (size_t v = 0; v < variables.size(); v++)
+        {
+            if (variables[v] == name && !found[v])
+            {
+                slot = (int)v;
+                found[v] = true;
+                break;
+            }
+        }
+        slots.push_back(slot);
+        start = end + 1;
+    }
+
+    for (size_t v = 0; v < variables.size(); v++)
+    {
+        if (!found[v])
+            throw runtime_error("no column for variable '" + string(variables[v]) + "'");
+    }
+    return slots;
+}
+
+// rows of the body cut at line ends
+static vector<string_view> split_chunks(string_view body)
+{
+    vector<string_view> chunks;
+    while (!body.empty())
+    {
+        size_t end = body.size();
+        if (end > CHUNK_BYTES)
+        {
+            const size_t newline = body.find('\n', CHUNK_BYTES);
+            end = newline == string_view::npos ? body.size() : newline + 1;
+        }
+        chunks.push_back(body.substr(0, end));
+        body.remove_prefix(end);
+    }
+    return chunks;
+}
+
+// a field that did not parse, the text points into the mapped file
+struct TBadField {
+    string_view text;
+    size_t column;
+};
+
+class TChunkEvaluator {
+private:
+    const TArithmeticExpression& expression;
+    const TExpressionBindings& bindings;
+    const vector<int>& slots;
+
+    vector<vector<double>> values;
+    vector<double> results;
+    TExpressionColumns columns;
+public:
+    size_t bad_fields = 0;
+    // the first of them, in file order
+    vector<TBadField> reported;
+
+    TChunkEvaluator(const TArithmeticExpression& expression, const TExpressionBindings& bindings,
+                    const vector<int>& slots)
+        : expression(expression)
+        , bindings(bindings)
+        , slots(slots)
+        , values(expression.get_variables().size(), vector<double>(BLOCK_ROWS))
+        , results(BLOCK_ROWS)
+    {
+        const auto variables = expression.get_variables();
+        for (size_t v = 0; v < variables.size(); v++)
+        {
+            columns.set(variables[v], values[v].data());
+        }
+    }
+
+    void evaluate(string_view chunk, string& out)
+    {
+        size_t rows = 0;
+        const auto flush = [&]() {
+            expression.calculate_batch(bindings, columns, rows, results.data());
+            for (size_t r = 0; r < rows; r++)
+            {
+                // shortest text that reads back as the same double
+                char buf[32];
+                const auto result = to_chars(buf, buf + sizeof(buf), results[r]);
+                out.append(buf, result.ptr);
+                out += '\n';
+            }
+            rows = 0;
+        };
+
+        const char* p = chunk.data();
+        const char* const end = p + chunk.size();
+        while (p < end)
+        {
+            const char* line_end = (const char*)memchr(p, '\n', end - p);
+            if (line_end == nullptr)
+                line_end = end;
+
+            if (trim(string_view(p, line_end - p)).empty())
+            {
+                p = line_end + 1;
+                continue;
+            }
+
+            for (auto& column : values)
+                column[rows] = NAN;
+
+            for (size_t field = 0; field < slots.size() && p <= line_end; field++)
+            {
+                const char* field_end = (const char*)memchr(p, ',', line_end - p);
+                if (field_end == nullptr)
+                    field_end = line_end;
+
+                if (slots[field] >= 0)
+                {
+                    const string_view text = trim(string_view(p, field_end - p));
+                    double value;
+                    const auto parsed = from_chars(text.data(), text.data() + text.size(), value);
+                    if (parsed.ec == errc() && parsed.ptr == text.data() + text.size())
+                        values[slots[field]][rows] = value;
+                    else if (bad_fields++ < MAX_REPORTED)
+                        reported.push_back({ text, field + 1 });
+                }
+                p = field_end + 1;
+            }
+            p = line_end + 1;
+
+            if (++rows == BLOCK_ROWS)
+                flush();
+        }
+        flush();
+    }
+};
+
+int main(int argc, char** argv)
+{
+    const char* output_path = nullptr;
+    string name = "result";
+    size_t threads = 0;
+    vector<const char*> positional;
+    bool bad_arguments = false;
+    for (int i = 1; i < argc; i++)
+    {
+        const string_view arg = argv[i];
+        if (arg.substr(0, 9) == "--output=")
+            output_path = argv[i] + 9;
+        else if (arg.substr(0, 7) == "--name=")
+            name = string(arg.substr(7));
+        else if (arg.substr(0, 10) == "--threads=")
+        {
+            const string_view count = arg.substr(10);
+            const auto parsed = from_chars(count.data(), count.data() + count.size(), threads);
+            if (parsed.ec != errc() || parsed.ptr != count.data() + count.size())
+                bad_arguments = true;
+        }
+        else if (arg.substr(0, 2) != "--")
+            positional.push_back(argv[i]);
+        else
+            bad_arguments = true;
+    }
+    if (bad_arguments || positional.size() != 2)
+    {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    try {
+        const TArithmeticExpression expression(positional[0]);
+        const TExpressionBindings bindings;
+
+        const TMappedFile file(positional[1]);
+        const string_view text = file.view();
+        const size_t header_end = min(text.find('\n'), text.size());
+        const vector<int> slots = map_columns(text.substr(0, header_end), expression.get_variables());
+        const vector<string_view> chunks = split_chunks(text.substr(min(header_end + 1, text.size())));
+
+        FILE* output = stdout;
+        if (output_path != nullptr && (output = fopen(output_path, "wb")) == nullptr)
+            throw runtime_error("cannot open " + string(output_path));
+        static char output_buffer[1 << 20];
+        setvbuf(output, output_buffer, _IOFBF, sizeof(output_buffer));
+        fprintf(output, "%s\n", name.c_str());
+
+        // chunks are evaluated a round at a time and written in file order
+        TThreadPool pool(threads);
+        const size_t round = pool.concurrency() * 2;
+        vector<string> outputs(round);
+        atomic<size_t> bad_fields { 0 };
+        vector<TBadField> reported;
+        mutex reported_mutex;
+        for (size_t first = 0; first < chunks.size(); first += round)
+        {
+            const size_t count = min(round, chunks.size() - first);
+            pool.parallel_for(count, 1, [&](size_t begin, size_t end) {
+                TChunkEvaluator evaluator(expression, bindings, slots);
+                for (size_t c = begin; c < end; c++)
+                {
+                    outputs[c].clear();
+                    evaluator.evaluate(chunks[first + c], outputs[c]);
+                }
+                bad_fields += evaluator.bad_fields;
+
+                lock_guard<mutex> lock(reported_mutex);
+                reported.insert(reported.end(), evaluator.reported.begin(), evaluator.reported.end());
+            });
+
+            for (size_t c = 0; c < count; c++)
+            {
+                fwrite(outputs[c].data(), 1, outputs[c].size(), output);
+            }
+        }
+
+        const bool failed = fflush(output) != 0 || ferror(output);
+        if (output != stdout)
+            fclose(output);
+        if (failed)
+            throw runtime_error("failed to write the results");
+
+        // line numbers are only counted for the fields reported
+        sort(reported.begin(), reported.end(), [](const TBadField& a, const TBadField& b) {
+            return a.text.data() < b.text.data();
+        });
+        size_t line = 1;
+        const char* counted = text.data();
+        for (size_t i = 0; i < reported.size() && i < MAX_REPORTED; i++)
+        {
+            line += count(counted, reported[i].text.data(), '\n');
+            counted = reported[i].text.data();
+            cerr << positional[1] << ":" << line << ": column " << reported[i].column
+                 << " is not a number: '" << reported[i].text << "'" << endl;
+        }
+        if (bad_fields > 0)
+            cerr << bad_fields << " fields could not be parsed and were taken as nan" << endl;
+    } catch (const exception& err) {
+        cerr << "error: " << err.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,428 @@
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "postfix.h"
+#include "registry.h"
+#include "parallel.h"
+#include "server_protocol.h"
+
+using namespace std;
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static volatile sig_atomic_t stopping = 0;
+
+static void usage()
+{
+    cerr << "usage: sample_postfix_server SOCKET CATALOG [--threads=N]" << endl
+         << "  Loads the formula catalog (text, or an image saved by TFormulaRegistry) once" << endl
+         << "  and evaluates its formulas for clients connecting to the Unix socket." << endl
+         << "  Evaluations of a formula that arrive together are run as one batch." << endl
+         << "  --threads=N  evaluate batches on N threads, 0 for all hardware threads (default 1)" << endl;
+}
+
+// images start with their magic, anything else is read as formula text
+static bool is_image(const string& path)
+{
+    ifstream in(path, ios::binary);
+    char magic[4] = {};
+    return in.read(magic, sizeof(magic)) && string_view(magic, sizeof(magic)) == "PFXI";
+}
+
+struct TConnection {
+    int fd;
+    string input;
+    string output;
+    bool closed = false;
+
+    // replies of the current round in request order, evaluations are filled in by their batch
+    struct TReply {
+        uint32_t id;
+        Protocol::Status status;
+        double value;
+        string body;
+    };
+    vector<TReply> replies;
+};
+
+// a formula with everything a batch needs
+struct TFormula {
+    shared_ptr<const TArithmeticExpression> expression;
+    vector<TSymbol> symbols;
+    string lookup_reply;
+};
+
+// the evaluations of one formula requested in a round, values row by row
+struct TBatch {
+    vector<double> values;
+    vector<pair<TConnection*, size_t>> targets;
+};
+
+class TServer {
+private:
+    const vector<TFormula> formulas;
+    const TExpressionBindings bindings;
+    TThreadPool pool;
+
+    // formula ids of the named formulas
+    unordered_map<string, size_t> index;
+
+    vector<unique_ptr<TConnection>> connections;
+    vector<TBatch> batches;
+
+    uint64_t requests = 0;
+    uint64_t evaluations = 0;
+    uint64_t batch_count = 0;
+
+    static vector<TFormula> prepare(const TFormulaRegistry& registry)
+    {
+        vector<TFormula> formulas;
+        for (const auto& entry : registry.get_entries())
+        {
+            TFormula formula { entry.expression, {}, {} };
+
+            const auto variables = entry.expression->get_variables();
+            Protocol::append<uint32_t>(formula.lookup_reply, (uint32_t)formulas.size());
+            Protocol::append<uint16_t>(formula.lookup_reply, (uint16_t)variables.size());
+            for (const auto& name : variables)
+            {
+                formula.symbols.push_back(TSymbolTable::global().find(name));
+                Protocol::append<uint16_t>(formula.lookup_reply, (uint16_t)name.size());
+                formula.lookup_reply += name;
+            }
+            formulas.push_back(move(formula));
+        }
+        return formulas;
+    }
+
+    void handle(TConnection& connection, const Protocol::TFrame& frame)
+    {
+        requests++;
+        connection.replies.push_back({ frame.id, Protocol::Status::Error, 0, {} });
+        TConnection::TReply& reply = connection.replies.back();
+
+        switch ((Protocol::Type)frame.type)
+        {
+            case Protocol::Type::Lookup: {
+                const auto it = index.find(string(frame.body));
+                if (it == index.end())
+                {
+                    reply.body = "Unknown formula: " + string(frame.body);
+                    return;
+                }
+                reply.status = Protocol::Status::Ok;
+                reply.body = formulas[it->second].lookup_reply;
+                return;
+            }
+            case Protocol::Type::Evaluate: {
+                const uint32_t formula = frame.body.size() >= sizeof(uint32_t)
+                        ? Protocol::read<uint32_t>(frame.body.data())
+                        : UINT32_MAX;
+                if (formula >= formulas.size())
+                {
+                    reply.body = "Unknown formula id";
+                    return;
+                }
+                const size_t count = formulas[formula].symbols.size();
+                if (frame.body.size() != sizeof(uint32_t) + count * sizeof(double))
+                {
+                    reply.body = "Expected " + to_string(count) + " values";
+                    return;
+                }
+
+                TBatch& batch = batches[formula];
+                const size_t start = batch.values.size();
+                batch.values.resize(start + count);
+                memcpy(batch.values.data() + start, frame.body.data() + sizeof(uint32_t), count * sizeof(double));
+                batch.targets.emplace_back(&connection, connection.replies.size() - 1);
+                evaluations++;
+                return;
+            }
+            default: {
+                reply.body = "Unknown request type";
+                return;
+            }
+        }
+    }
+
+    void receive(TConnection& connection)
+    {
+        char buffer[64 * 1024];
+        while (true)
+        {
+            const ssize_t received = ::read(connection.fd, buffer, sizeof(buffer));
+            if (received > 0)
+            {
+                connection.input.append(buffer, (size_t)received);
+                continue;
+            }
+            if (received < 0 && errno == EINTR)
+                continue;
+            if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+                connection.closed = true;
+            break;
+        }
+
+        try {
+            size_t consumed = 0;
+            Protocol::TFrame frame;
+            while (size_t size = Protocol::next_frame(string_view(connection.input).substr(consumed), frame))
+            {
+                handle(connection, frame);
+                consumed += size;
+            }
+            connection.input.erase(0, consumed);
+        } catch (const exception&) {
+            // the stream cannot be resynchronised after a bad frame
+            connection.closed = true;
+        }
+    }
+
+    // every formula with pending evaluations runs once over all of them
+    void evaluate_batches()
+    {
+        vector<size_t> pending;
+        for (size_t f = 0; f < batches.size(); f++)
+        {
+            if (!batches[f].targets.empty())
+                pending.push_back(f);
+        }
+        batch_count += pending.size();
+
+        pool.parallel_for(pending.size(), 1, [&](size_t begin, size_t end) {
+            vector<double> results;
+            for (size_t p = begin; p < end; p++)
+            {
+                const TFormula& formula = formulas[pending[p]];
+                TBatch& batch = batches[pending[p]];
+                const size_t rows = batch.targets.size();
+                const size_t stride = formula.symbols.size();
+
+                TExpressionColumns columns;
+                for (size_t v = 0; v < stride; v++)
+                {
+                    columns.set(formula.symbols[v], batch.values.data() + v, stride);
+                }
+
+                results.resize(rows);
+                string error;
+                try {
+                    formula.expression->calculate_batch(bindings, columns, rows, results.data());
+                } catch (const exception& err) {
+                    error = err.what();
+                }
+
+                for (size_t r = 0; r < rows; r++)
+                {
+                    TConnection::TReply& reply = batch.targets[r].first->replies[batch.targets[r].second];
+                    reply.status = error.empty() ? Protocol::Status::Ok : Protocol::Status::Error;
+                    reply.value = results[r];
+                    reply.body = error;
+                }
+                batch.values.clear();
+                batch.targets.clear();
+            }
+        });
+    }
+
+    void send(TConnection& connection)
+    {
+        for (const auto& reply : connection.replies)
+        {
+            const size_t start = Protocol::begin_frame(connection.output, (uint8_t)reply.status, reply.id);
+            if (reply.status == Protocol::Status::Ok && reply.body.empty())
+                Protocol::append<double>(connection.output, reply.value);
+            else
+                connection.output += reply.body;
+            Protocol::finish_frame(connection.output, start);
+        }
+        connection.replies.clear();
+
+        size_t sent = 0;
+        while (sent < connection.output.size())
+        {
+            const ssize_t written = ::send(connection.fd, connection.output.data() + sent,
+                                           connection.output.size() - sent, MSG_NOSIGNAL);
+            if (written > 0)
+                sent += (size_t)written;
+            else if (errno == EINTR)
+                continue;
+            else
+            {
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    connection.closed = true;
+                break;
+            }
+        }
+        connection.output.erase(0, sent);
+    }
+public:
+    TServer(const TFormulaRegistry& registry, size_t threads)
+        : formulas(prepare(registry))
+        , pool(threads)
+        , batches(formulas.size())
+    {
+        const auto& entries = registry.get_entries();
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            if (!entries[i].name.empty())
+                index.emplace(entries[i].name, i);
+        }
+    }
+
+    void serve(int listener)
+    {
+        vector<pollfd> fds;
+        while (!stopping)
+        {
+            fds.clear();
+            fds.push_back({ listener, POLLIN, 0 });
+            for (const auto& connection : connections)
+            {
+                const short events = connection->output.empty() ? POLLIN : (POLLIN | POLLOUT);
+                fds.push_back({ connection->fd, events, 0 });
+            }
+
+            if (poll(fds.data(), fds.size(), -1) < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                throw runtime_error(string("poll failed: ") + strerror(errno));
+            }
+
+            for (size_t i = 1; i < fds.size(); i++)
+            {
+                if (fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+                    receive(*connections[i - 1]);
+            }
+            evaluate_batches();
+            for (const auto& connection : connections)
+            {
+                if (!connection->replies.empty() || !connection->output.empty())
+                    send(*connection);
+            }
+
+            // drop closed connections before new ones take their place in fds
+            for (auto& connection : connections)
+            {
+                if (connection->closed)
+                {
+                    ::close(connection->fd);
+                    connection.reset();
+                }
+            }
+            connections.erase(remove(connections.begin(), connections.end(), nullptr), connections.end());
+
+            if (fds[0].revents & POLLIN)
+            {
+                int fd;
+                while ((fd = accept(listener, nullptr, nullptr)) >= 0)
+                {
+                    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+                    connections.push_back(make_unique<TConnection>());
+                    connections.back()->fd = fd;
+                }
+            }
+        }
+
+        for (const auto& connection : connections)
+        {
+            ::close(connection->fd);
+        }
+        cerr << requests << " requests, " << evaluations << " evaluations in " << batch_count << " batches";
+        if (batch_count > 0)
+            cerr << ", " << (double)evaluations / batch_count << " per batch";
+        cerr << endl;
+    }
+};
+
+int main(int argc, char** argv)
+{
+    size_t threads = 1;
+    vector<string> arguments;
+    bool bad_arguments = false;
+    for (int i = 1; i < argc; i++)
+    {
+        const string_view arg = argv[i];
+        if (arg.substr(0, 10) == "--threads=")
+        {
+            const string_view count = arg.substr(10);
+            const auto parsed = from_chars(count.data(), count.data() + count.size(), threads);
+            if (parsed.ec != errc() || parsed.ptr != count.data() + count.size())
+                bad_arguments = true;
+        }
+        else if (arg.substr(0, 2) != "--")
+            arguments.emplace_back(arg);
+        else
+            bad_arguments = true;
+    }
+    if (bad_arguments || arguments.size() != 2)
+    {
+        usage();
+        return EXIT_FAILURE;
+    }
+    const string& socket_path = arguments[0];
+
+    try {
+        const TFormulaRegistry registry = is_image(arguments[1]) ? TFormulaRegistry::load_image(arguments[1])
+                                                                 : TFormulaRegistry::load(arguments[1]);
+        for (const auto& error : registry.get_errors())
+        {
+            cerr << arguments[1] << ":" << error.line << ":" << error.column << ": " << error.message << endl;
+        }
+        cerr << registry.size() << " formulas loaded" << endl;
+
+        sockaddr_un address {};
+        address.sun_family = AF_UNIX;
+        if (socket_path.size() >= sizeof(address.sun_path))
+            throw runtime_error("socket path is too long");
+        memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+        const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener < 0)
+            throw runtime_error(string("cannot create socket: ") + strerror(errno));
+        unlink(socket_path.c_str());
+        if (bind(listener, (const sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 128) != 0)
+            throw runtime_error("cannot listen on " + socket_path + ": " + strerror(errno));
+        fcntl(listener, F_SETFL, fcntl(listener, F_GETFL) | O_NONBLOCK);
+
+        struct sigaction action {};
+        action.sa_handler = [](int) { stopping = 1; };
+        sigaction(SIGINT, &action, nullptr);
+        sigaction(SIGTERM, &action, nullptr);
+
+        TServer(registry, threads).serve(listener);
+
+        ::close(listener);
+        unlink(socket_path.c_str());
+    } catch (const exception& err) {
+        cerr << "error: " << err.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+#else
+
+int main()
+{
+    cerr << "sample_postfix_server needs Unix domain sockets" << endl;
+    return EXIT_FAILURE;
+}
+
+#endif
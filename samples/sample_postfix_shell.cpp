@@ -1,21 +1,194 @@
+#include <charconv>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "postfix.h"
+#include "parallel.h"
 
 using namespace std;
 
-int main()
+// expressions evaluated per round, their results are written in input order
+static const size_t BATCH_LINES = 64 * 1024;
+static const size_t BATCH_GRAIN = 512;
+static const size_t READ_SIZE = 1 << 20;
+
+static void usage()
+{
+    cerr << "usage: sample_postfix_shell [--batch [FILE] [--threads=N]]" << endl
+         << "  --batch      evaluate one expression per line of FILE or stdin," << endl
+         << "               one result (or 'error: ...') per line on stdout" << endl
+         << "  --threads=N  evaluate on N threads, 0 for all hardware threads" << endl;
+}
+
+static void append_result(string& out, string_view line)
+{
+    while (!line.empty() && (line.back() == '\r' || line.back() == ' '))
+        line.remove_suffix(1);
+    if (line.empty())
+    {
+        out += '\n';
+        return;
+    }
+
+    try {
+        const double value = TArithmeticExpression(string(line)).calculate();
+        // shortest text that reads back as the same double
+        char buf[32];
+        const auto result = to_chars(buf, buf + sizeof(buf), value);
+        out.append(buf, result.ptr);
+    } catch (const exception& err) {
+        out += "error: ";
+        out += err.what();
+    }
+    out += '\n';
+}
+
+// Reads newline separated lines in large blocks. The views returned by
+// next_batch stay valid until the following call
+class TLineReader {
+private:
+    FILE* file;
+    string buffer;
+    size_t consumed = 0;
+    bool eof = false;
+public:
+    explicit TLineReader(FILE* file)
+        : file(file)
+    {}
+
+    bool next_batch(vector<string_view>& lines, size_t max_lines)
+    {
+        lines.clear();
+        buffer.erase(0, consumed);
+        consumed = 0;
+
+        while (lines.size() < max_lines)
+        {
+            const char* start = buffer.data() + consumed;
+            const void* newline = memchr(start, '\n', buffer.size() - consumed);
+            if (newline != nullptr)
+            {
+                const size_t length = (const char*)newline - start;
+                lines.emplace_back(start, length);
+                consumed += length + 1;
+                continue;
+            }
+
+            if (eof)
+            {
+                // a last line without a newline
+                if (consumed < buffer.size())
+                {
+                    lines.emplace_back(start, buffer.size() - consumed);
+                    consumed = buffer.size();
+                }
+                break;
+            }
+
+            // views into the buffer are about to move
+            if (!lines.empty())
+                break;
+
+            const size_t old_size = buffer.size();
+            buffer.resize(old_size + READ_SIZE);
+            const size_t read = fread(&buffer[old_size], 1, READ_SIZE, file);
+            buffer.resize(old_size + read);
+            eof = read == 0;
+        }
+        return !lines.empty();
+    }
+};
+
+static int run_batch(FILE* input, size_t threads)
 {
-    setlocale(LC_NUMERIC, "en_US.UTF-8");
-    ///
+    TThreadPool pool(threads);
+    TLineReader reader(input);
+
+    static char out_buffer[READ_SIZE];
+    setvbuf(stdout, out_buffer, _IOFBF, sizeof(out_buffer));
+
+    vector<string_view> lines;
+    vector<string> outputs;
+    while (reader.next_batch(lines, BATCH_LINES))
+    {
+        outputs.resize((lines.size() + BATCH_GRAIN - 1) / BATCH_GRAIN);
+        pool.parallel_for(lines.size(), BATCH_GRAIN, [&](size_t begin, size_t end) {
+            string& out = outputs[begin / BATCH_GRAIN];
+            out.clear();
+            for (size_t i = begin; i < end; i++)
+            {
+                append_result(out, lines[i]);
+            }
+        });
+
+        for (const auto& out : outputs)
+        {
+            fwrite(out.data(), 1, out.size(), stdout);
+        }
+    }
+
+    fflush(stdout);
+    return ferror(input) || ferror(stdout) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
 
+static int run_interactive()
+{
     string infix;
     while (true) {
         cout << ">>> ";
-        cin >> infix;
+        if (!(cin >> infix))
+            break;
         cout << TArithmeticExpression(infix).calculate() << endl;
         cout << endl;
     }
 
     return EXIT_SUCCESS;
 }
+
+int main(int argc, char** argv)
+{
+    bool batch = false;
+    size_t threads = 1;
+    const char* path = nullptr;
+    for (int i = 1; i < argc; i++)
+    {
+        const string_view arg = argv[i];
+        if (arg == "--batch")
+            batch = true;
+        else if (arg.substr(0, 10) == "--threads=")
+        {
+            const string_view count = arg.substr(10);
+            const auto parsed = from_chars(count.data(), count.data() + count.size(), threads);
+            if (parsed.ec != errc() || parsed.ptr != count.data() + count.size())
+            {
+                usage();
+                return EXIT_FAILURE;
+            }
+        }
+        else if (batch && path == nullptr && arg.substr(0, 2) != "--")
+            path = argv[i];
+        else
+        {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!batch)
+        return run_interactive();
+
+    FILE* input = stdin;
+    if (path != nullptr && (input = fopen(path, "rb")) == nullptr)
+    {
+        cerr << "cannot open " << path << endl;
+        return EXIT_FAILURE;
+    }
+
+    const int status = run_batch(input, threads);
+    if (input != stdin)
+        fclose(input);
+    return status;
+}
@@ -0,0 +1,93 @@
+#ifndef __SERVER_PROTOCOL_H__
+#define __SERVER_PROTOCOL_H__
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// Wire format of sample_postfix_server, integers and doubles are little-endian.
+//
+//   frame:     u32 size of the rest, u8 type (status in replies), u32 request id, body
+//   Lookup:    formula name
+//              -> Ok: u32 formula id, u16 variable count, names as (u16 length, bytes)
+//   Evaluate:  u32 formula id, f64 value of every variable in lookup order
+//              -> Ok: f64 result
+//   failures   -> Error: message
+//
+// Requests may be pipelined, the replies of a connection come in request order.
+// The helpers below copy values as they are, so they assume a little-endian host
+namespace Protocol {
+
+enum class Type : uint8_t {
+    Lookup = 1,
+    Evaluate = 2
+};
+
+enum class Status : uint8_t {
+    Ok = 0,
+    Error = 1
+};
+
+const size_t HEADER_SIZE = 9;
+const size_t MAX_FRAME = 1 << 20;
+
+struct TFrame {
+    uint8_t type = 0;
+    uint32_t id = 0;
+    std::string_view body;
+};
+
+template<class T>
+T read(const char* data)
+{
+    T value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+template<class T>
+void append(std::string& out, T value)
+{
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// opens a frame in out, the size is filled in by finish_frame
+inline size_t begin_frame(std::string& out, uint8_t type, uint32_t id)
+{
+    const size_t start = out.size();
+    append<uint32_t>(out, 0);
+    append<uint8_t>(out, type);
+    append<uint32_t>(out, id);
+    return start;
+}
+
+inline void finish_frame(std::string& out, size_t start)
+{
+    const auto size = (uint32_t)(out.size() - start - sizeof(uint32_t));
+    memcpy(&out[start], &size, sizeof(size));
+}
+
+// Size of the first frame in data, 0 while it is incomplete.
+// Throws for frames larger than MAX_FRAME
+inline size_t next_frame(std::string_view data, TFrame& frame)
+{
+    if (data.size() < HEADER_SIZE)
+        return 0;
+
+    const uint32_t size = read<uint32_t>(data.data());
+    if (size < HEADER_SIZE - sizeof(uint32_t) || size > MAX_FRAME)
+        throw std::runtime_error("Bad frame size");
+    if (data.size() < sizeof(uint32_t) + size)
+        return 0;
+
+    frame.type = (uint8_t)data[4];
+    frame.id = read<uint32_t>(data.data() + 5);
+    frame.body = data.substr(HEADER_SIZE, size - (HEADER_SIZE - sizeof(uint32_t)));
+    return sizeof(uint32_t) + size;
+}
+
+}
+
+#endif // __SERVER_PROTOCOL_H__
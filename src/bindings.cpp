@@ -0,0 +1,58 @@
+#include "postfix.h"
+#include "operators.h"
+
+TExpressionBindings::TExpressionBindings()
+{
+    for (const auto& constant : Operators::CONSTANTS)
+    {
+        set(constant.first, constant.second);
+    }
+    for (const auto& function : Operators::STD_FUNCTIONS)
+    {
+        set_function(function.first, function.second);
+    }
+}
+
+void TExpressionBindings::set(TSymbol symbol, double value)
+{
+    if (symbol >= values.size())
+    {
+        values.resize(symbol + 1);
+        bound.resize(symbol + 1);
+    }
+    values[symbol] = value;
+    bound[symbol] = true;
+}
+
+void TExpressionBindings::set(std::string_view name, double value)
+{
+    set(TSymbolTable::global().intern(name), value);
+}
+
+void TExpressionBindings::set_function(TSymbol symbol, std::shared_ptr<TArithmeticExpressionFunction> function)
+{
+    if (symbol >= functions.size())
+    {
+        functions.resize(symbol + 1);
+    }
+    functions[symbol] = std::move(function);
+}
+
+void TExpressionBindings::set_function(std::string_view name, std::shared_ptr<TArithmeticExpressionFunction> function)
+{
+    set_function(TSymbolTable::global().intern(name), std::move(function));
+}
+
+void TExpressionColumns::set(TSymbol symbol, const double* values, size_t stride)
+{
+    if (symbol >= columns.size())
+    {
+        columns.resize(symbol + 1);
+    }
+    columns[symbol] = { values, stride };
+}
+
+void TExpressionColumns::set(std::string_view name, const double* values, size_t stride)
+{
+    set(TSymbolTable::global().intern(name), values, stride);
+}
@@ -0,0 +1,41 @@
+#include "bulk.h"
+
+TCompilationResult try_compile(std::string_view infix)
+{
+    TCompilationResult result;
+    try {
+        result.expression = std::make_shared<const TArithmeticExpression>(infix);
+    } catch (const expression_validation_error& err) {
+        result.error = { err.what(), err.get_pos(), err.get_cause() };
+    } catch (const std::exception& err) {
+        result.error = { err.what() };
+    }
+    return result;
+}
+
+template<class String>
+static std::vector<TCompilationResult> compile_all(const std::vector<String>& infixes, TThreadPool& pool)
+{
+    std::vector<TCompilationResult> results(infixes.size());
+
+    // formulas are cheap to compile, so hand them out in batches to keep the counter cold
+    const size_t grain = 64;
+    pool.parallel_for(infixes.size(), grain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            results[i] = try_compile(infixes[i]);
+        }
+    });
+
+    return results;
+}
+
+std::vector<TCompilationResult> compile_bulk(const std::vector<std::string>& infixes, TThreadPool& pool)
+{
+    return compile_all(infixes, pool);
+}
+
+std::vector<TCompilationResult> compile_bulk(const std::vector<std::string_view>& infixes, TThreadPool& pool)
+{
+    return compile_all(infixes, pool);
+}
@@ -0,0 +1,124 @@
+#include "cache.h"
+#include "validator.h"
+#include <functional>
+
+TArithmeticExpressionCache::TArithmeticExpressionCache(size_t capacity, size_t shard_count)
+    : shard_capacity(capacity > 0
+        ? (capacity + shard_count - 1) / (shard_count > 0 ? shard_count : 1)
+        : throw std::invalid_argument("Cache capacity should be greater than 0"))
+{
+    if (shard_count == 0)
+        throw std::invalid_argument("Cache should have at least one shard");
+
+    shards.reserve(shard_count);
+    for (size_t i = 0; i < shard_count; i++)
+    {
+        shards.push_back(std::make_unique<TShard>());
+    }
+}
+
+TArithmeticExpressionCache::TShard& TArithmeticExpressionCache::shard_for(const std::string& key) const
+{
+    return *shards[std::hash<std::string>{}(key) % shards.size()];
+}
+
+TArithmeticExpressionCache::TEntry TArithmeticExpressionCache::get(const std::string& infix)
+{
+    const std::string key = normalize(infix);
+    TShard& shard = shard_for(key);
+
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        const auto it = shard.index.find(key);
+        if (it != shard.index.end())
+        {
+            shard.order.splice(shard.order.begin(), shard.order, it->second);
+            shard.hits++;
+            return it->second->second;
+        }
+    }
+    shard.misses++;
+
+    // compile outside of the lock so that a slow expression does not stall the shard
+    TEntry compiled = std::make_shared<const TArithmeticExpression>(infix);
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    const auto it = shard.index.find(key);
+    if (it != shard.index.end())
+    {
+        // another thread got here first, keep a single instance
+        shard.order.splice(shard.order.begin(), shard.order, it->second);
+        return it->second->second;
+    }
+
+    shard.order.emplace_front(key, compiled);
+    shard.index.emplace(key, shard.order.begin());
+
+    while (shard.order.size() > shard_capacity)
+    {
+        shard.index.erase(shard.order.back().first);
+        shard.order.pop_back();
+        shard.evictions++;
+    }
+
+    return compiled;
+}
+
+TArithmeticExpressionCache::TStatistics TArithmeticExpressionCache::statistics() const
+{
+    TStatistics stats = { 0, 0, 0 };
+    for (const auto& shard : shards)
+    {
+        stats.hits += shard->hits;
+        stats.misses += shard->misses;
+        stats.evictions += shard->evictions;
+    }
+    return stats;
+}
+
+size_t TArithmeticExpressionCache::size() const
+{
+    size_t total = 0;
+    for (const auto& shard : shards)
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        total += shard->order.size();
+    }
+    return total;
+}
+
+size_t TArithmeticExpressionCache::capacity() const noexcept
+{
+    return shard_capacity * shards.size();
+}
+
+void TArithmeticExpressionCache::clear()
+{
+    for (const auto& shard : shards)
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->index.clear();
+        shard->order.clear();
+    }
+}
+
+std::string TArithmeticExpressionCache::normalize(const std::string& infix)
+{
+    std::string key;
+    key.reserve(infix.size());
+    for (const char c : infix)
+    {
+        // a space right after a dot is an error the compiler still has to see
+        if (get_type(c) != ExpressionSymbol::Space || (!key.empty() && key.back() == '.'))
+            key += c;
+    }
+    return key;
+}
+
+TArithmeticExpressionCache& TArithmeticExpressionCache::global()
+{
+    static TArithmeticExpressionCache cache;
+    return cache;
+}
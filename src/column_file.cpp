@@ -0,0 +1,184 @@
+#include "column_file.h"
+#include <cstring>
+
+namespace {
+
+const char MAGIC[4] = { 'P', 'F', 'X', 'C' };
+const size_t HEADER_SIZE = 24;
+
+// rows evaluated by one pool task
+const size_t GRAIN_ROWS = 64 * 1024;
+
+void require_little_endian()
+{
+    const uint16_t probe = 1;
+    uint8_t first;
+    memcpy(&first, &probe, 1);
+    if (first != 1)
+        throw column_file_error("Column files can only be mapped on little-endian hosts");
+}
+
+template<class T>
+T read(const char* data)
+{
+    T value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+template<class T>
+void write(char*& out, T value)
+{
+    memcpy(out, &value, sizeof(value));
+    out += sizeof(value);
+}
+
+}
+
+TColumnFile TColumnFile::open_raw(const std::string& path, const std::string& name)
+{
+    require_little_endian();
+
+    TColumnFile result;
+    result.file = TMappedFile(path);
+    if (result.file.size() % sizeof(double) != 0)
+        throw column_file_error("Raw column file size is not a multiple of 8: " + path);
+
+    result.names = { name };
+    result.values = reinterpret_cast<const double*>(result.file.data());
+    result.row_count = result.file.size() / sizeof(double);
+    return result;
+}
+
+TColumnFile TColumnFile::open_interleaved(const std::string& path)
+{
+    require_little_endian();
+
+    TColumnFile result;
+    result.file = TMappedFile(path);
+    const char* data = result.file.data();
+    const size_t size = result.file.size();
+
+    if (size < HEADER_SIZE || memcmp(data, MAGIC, sizeof(MAGIC)) != 0)
+        throw column_file_error("Not a column file: " + path);
+    if (read<uint32_t>(data + 4) != VERSION)
+        throw column_file_error("Unsupported column file version: " + path);
+
+    const uint32_t count = read<uint32_t>(data + 8);
+    const uint32_t offset = read<uint32_t>(data + 12);
+    const uint64_t rows = read<uint64_t>(data + 16);
+    if (count == 0 || offset % sizeof(double) != 0 || offset < HEADER_SIZE || offset > size
+        || (size - offset) / sizeof(double) / count < rows)
+        throw column_file_error("Malformed column file header: " + path);
+
+    size_t position = HEADER_SIZE;
+    for (uint32_t c = 0; c < count; c++)
+    {
+        if (offset - position < 4)
+            throw column_file_error("Malformed column file header: " + path);
+        const uint32_t length = read<uint32_t>(data + position);
+        position += 4;
+        if (offset - position < length)
+            throw column_file_error("Malformed column file header: " + path);
+        result.names.emplace_back(data + position, length);
+        position += length;
+    }
+
+    result.values = reinterpret_cast<const double*>(data + offset);
+    result.row_count = rows;
+    return result;
+}
+
+void TColumnFile::write_interleaved(const std::string& path, const std::vector<std::string>& names,
+                                    const std::vector<const double*>& columns, size_t rows)
+{
+    require_little_endian();
+    if (names.empty() || names.size() != columns.size())
+        throw column_file_error("Every column needs a name");
+
+    size_t offset = HEADER_SIZE;
+    for (const auto& name : names)
+    {
+        offset += 4 + name.size();
+    }
+    offset = (offset + sizeof(double) - 1) / sizeof(double) * sizeof(double);
+
+    TMappedOutputFile output(path, offset + rows * names.size() * sizeof(double));
+    char* out = output.data();
+    memcpy(out, MAGIC, sizeof(MAGIC));
+    out += sizeof(MAGIC);
+    write<uint32_t>(out, VERSION);
+    write<uint32_t>(out, (uint32_t)names.size());
+    write<uint32_t>(out, (uint32_t)offset);
+    write<uint64_t>(out, rows);
+    for (const auto& name : names)
+    {
+        write<uint32_t>(out, (uint32_t)name.size());
+        memcpy(out, name.data(), name.size());
+        out += name.size();
+    }
+
+    // the padding is already zero
+    double* values = reinterpret_cast<double*>(output.data() + offset);
+    for (size_t r = 0; r < rows; r++)
+    {
+        for (size_t c = 0; c < columns.size(); c++)
+        {
+            *values++ = columns[c][r];
+        }
+    }
+    output.close();
+}
+
+size_t evaluate_column_files(const TArithmeticExpression& expression, const TExpressionBindings& bindings,
+                             const std::vector<const TColumnFile*>& inputs, const std::string& output_path,
+                             TThreadPool& pool)
+{
+    require_little_endian();
+    if (inputs.empty())
+        throw column_file_error("No input columns");
+
+    const size_t rows = inputs.front()->rows();
+    for (const TColumnFile* input : inputs)
+    {
+        if (input->rows() != rows)
+            throw column_file_error("Column files have different numbers of rows");
+    }
+
+    struct TBinding {
+        TSymbol symbol;
+        const double* values;
+        size_t stride;
+    };
+    std::vector<TBinding> columns;
+    for (const TColumnFile* input : inputs)
+    {
+        for (size_t c = 0; c < input->columns().size(); c++)
+        {
+            columns.push_back({ TSymbolTable::global().intern(input->columns()[c]), input->column(c), input->stride() });
+        }
+    }
+
+    // reports missing variables even when there are no rows
+    TExpressionColumns all;
+    for (const auto& column : columns)
+    {
+        all.set(column.symbol, column.values, column.stride);
+    }
+    expression.calculate_batch(bindings, all, 0, nullptr);
+
+    TMappedOutputFile output(output_path, rows * sizeof(double));
+    double* results = reinterpret_cast<double*>(output.data());
+
+    pool.parallel_for(rows, GRAIN_ROWS, [&](size_t begin, size_t end) {
+        TExpressionColumns chunk;
+        for (const auto& column : columns)
+        {
+            chunk.set(column.symbol, column.values + begin * column.stride, column.stride);
+        }
+        expression.calculate_batch(bindings, chunk, end - begin, results + begin);
+    });
+
+    output.close();
+    return rows;
+}
@@ -0,0 +1,91 @@
+#include "compile_stats.h"
+#include "list.h"
+#include <mutex>
+
+namespace {
+
+std::mutex global_mutex;
+TCompileStats global_stats;
+
+thread_local TCompileStats last_stats;
+
+#ifdef POSTFIX_COMPILE_STATS
+thread_local uint64_t list_allocation_count = 0;
+#endif
+
+}
+
+TCompileStats& TCompileStats::operator+=(const TCompileStats& other)
+{
+    compilations += other.compilations;
+    failures += other.failures;
+    for (size_t i = 0; i < (size_t)Phase::Count; i++)
+    {
+        phase_ns[i] += other.phase_ns[i];
+    }
+    tokens += other.tokens;
+    if (other.stack_high_water > stack_high_water)
+        stack_high_water = other.stack_high_water;
+    list_allocations += other.list_allocations;
+    return *this;
+}
+
+uint64_t TCompileStats::total_ns() const
+{
+    uint64_t total = 0;
+    for (const uint64_t ns : phase_ns)
+    {
+        total += ns;
+    }
+    return total;
+}
+
+const char* TCompileStats::phase_name(Phase phase)
+{
+    static const char* const NAMES[] = { "validate", "lex", "shunt", "emit", "finalize" };
+    return NAMES[(size_t)phase];
+}
+
+TCompileStats TCompileStats::global()
+{
+    std::lock_guard<std::mutex> lock(global_mutex);
+    return global_stats;
+}
+
+void TCompileStats::reset_global()
+{
+    std::lock_guard<std::mutex> lock(global_mutex);
+    global_stats = TCompileStats();
+}
+
+TCompileStats TCompileStats::last()
+{
+    return last_stats;
+}
+
+#ifdef POSTFIX_COMPILE_STATS
+
+// used by the compiler to publish a finished compilation
+void publish_compile_stats(const TCompileStats& stats)
+{
+    last_stats = stats;
+
+    std::lock_guard<std::mutex> lock(global_mutex);
+    global_stats += stats;
+}
+
+uint64_t TCompileStats::thread_list_allocations() noexcept
+{
+    return list_allocation_count;
+}
+
+void TCompileStats::count_list_allocation() noexcept
+{
+    list_allocation_count++;
+}
+
+// the library leaves the global operator new alone and counts the
+// allocations of its own lists
+static const bool list_hook_installed = (list_allocation_hook = &TCompileStats::count_list_allocation, true);
+
+#endif
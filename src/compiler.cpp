@@ -0,0 +1,304 @@
+#include "compiler.h"
+#include "operators.h"
+#include <algorithm>
+#include <exception>
+
+#ifdef POSTFIX_COMPILE_STATS
+
+TCompileStats::Phase TExpressionCompiler::enter(TCompileStats::Phase next)
+{
+    const auto now = std::chrono::steady_clock::now();
+    stats.phase_ns[(size_t)phase] += std::chrono::duration_cast<std::chrono::nanoseconds>(now - phase_start).count();
+    phase_start = now;
+
+    const TCompileStats::Phase previous = phase;
+    phase = next;
+    return previous;
+}
+
+// charges the enclosing block to a phase, phases nest
+struct TExpressionCompiler::TPhaseScope {
+    TExpressionCompiler& compiler;
+    const TCompileStats::Phase previous;
+
+    TPhaseScope(TExpressionCompiler& compiler, TCompileStats::Phase phase)
+        : compiler(compiler)
+        , previous(compiler.enter(phase))
+    {}
+    ~TPhaseScope()
+    {
+        compiler.enter(previous);
+    }
+};
+
+// publishes the statistics of the compilation, failed or not
+struct TExpressionCompiler::TRecord {
+    TExpressionCompiler& compiler;
+    const uint64_t list_allocations = TCompileStats::thread_list_allocations();
+    const int exceptions = std::uncaught_exceptions();
+
+    explicit TRecord(TExpressionCompiler& compiler)
+        : compiler(compiler)
+    {
+        compiler.stats = TCompileStats();
+        compiler.phase = TCompileStats::Phase::Lex;
+        compiler.phase_start = std::chrono::steady_clock::now();
+    }
+    ~TRecord()
+    {
+        compiler.enter(TCompileStats::Phase::Lex);
+
+        TCompileStats& stats = compiler.stats;
+        stats.compilations = 1;
+        stats.failures = std::uncaught_exceptions() > exceptions ? 1 : 0;
+        stats.tokens = compiler.target.tokens.size();
+        stats.list_allocations = TCompileStats::thread_list_allocations() - list_allocations;
+        publish_compile_stats(stats);
+    }
+};
+
+#define COMPILE_PHASE(name) const TPhaseScope phase_scope(*this, TCompileStats::Phase::name)
+#define COMPILE_STATS(statement) statement
+
+#else
+
+#define COMPILE_PHASE(name)
+#define COMPILE_STATS(statement)
+
+#endif
+
+TExpressionCompiler::TExpressionCompiler(TArithmeticExpression& target)
+    : target(target)
+{}
+
+void TExpressionCompiler::compile(std::string_view infix)
+{
+    COMPILE_STATS(const TRecord record(*this));
+
+    // Errors of the lexer and the shunting-yard are held back until the
+    // whole input is validated: validation errors take precedence, even
+    // when they come later in the input
+    std::exception_ptr deferred;
+    for (const char c : infix)
+    {
+        const ExpressionSymbol type = get_type(c);
+        {
+            COMPILE_PHASE(Validate);
+            validator.feed(type);
+        }
+
+        if (deferred)
+            continue;
+        try {
+            lex(c, type);
+        } catch (...) {
+            deferred = std::current_exception();
+        }
+    }
+    {
+        COMPILE_PHASE(Validate);
+        validator.finish();
+    }
+    if (deferred)
+        std::rethrow_exception(deferred);
+
+    flush('\0');
+    while (!stack.empty())
+    {
+        emit(stack.pop_element());
+    }
+
+    COMPILE_PHASE(Finalize);
+    for (auto* symbols : { &target.variables, &target.func_names })
+    {
+        std::sort(symbols->begin(), symbols->end());
+        symbols->erase(std::unique(symbols->begin(), symbols->end()), symbols->end());
+    }
+
+    if (!target.verify_program())
+        throw std::logic_error("Compiled an unbalanced program");
+}
+
+void TExpressionCompiler::lex(const char c, const ExpressionSymbol type)
+{
+    switch (type)
+    {
+        case ExpressionSymbol::Space: {
+            break;
+        }
+        case ExpressionSymbol::OpeningBracket:
+        case ExpressionSymbol::ClosingBracket: {
+            flush(c);
+            shunt(TLexeme { TLexeme::Type::Bracket, TLexemeValue(std::string{c}), validator.position() });
+            break;
+        }
+        case ExpressionSymbol::Operator:
+        case ExpressionSymbol::Minus:
+        case ExpressionSymbol::PostfixOperator: {
+            flush(c);
+            shunt(TLexeme { TLexeme::Type::Operator, TLexemeValue(std::string{c}), validator.position() });
+            break;
+        }
+        default: {
+            if (buf.empty())
+                buf_pos = validator.position();
+            buf += c;
+            if (buf_type == TLexeme::Type::Number && type != ExpressionSymbol::Digit && c != '.')
+                buf_type = TLexeme::Type::Variable;
+            break;
+        }
+    }
+}
+
+void TExpressionCompiler::flush(const char next)
+{
+    if (buf.empty())
+        return;
+
+    // a name directly followed by an opening bracket is a call
+    const TLexeme::Type type = (buf_type == TLexeme::Type::Variable && next == '(')
+            ? TLexeme::Type::Function
+            : buf_type;
+    shunt(TLexeme { type, TLexemeValue(buf), buf_pos });
+
+    buf.clear();
+    buf_type = TLexeme::Type::Number;
+}
+
+void TExpressionCompiler::shunt(const TLexeme& lexeme)
+{
+    COMPILE_PHASE(Shunt);
+
+    const auto pos = (uint32_t)lexeme.pos;
+    const bool unary_allowed = unary_context;
+    unary_context = false;
+
+    switch (lexeme.type)
+    {
+        case TLexeme::Type::Bracket: {
+            if (lexeme.value.as_char() == '(')
+            {
+                stack.push(TPending { TLexeme::Type::Bracket, '(', pos, TSymbolTable::NONE });
+                unary_context = true;
+            }
+            else // lexeme.value.as_char() == ')'
+            {
+                while (stack.top().type != TLexeme::Type::Bracket) {
+                    emit(stack.pop_element());
+                }
+                stack.pop();
+
+                if (!stack.empty() && stack.top().type == TLexeme::Type::Function)
+                {
+                    emit(stack.pop_element());
+                }
+            }
+            break;
+        }
+        case TLexeme::Type::Operator: {
+            char current = lexeme.value.as_char();
+            if (current == '-' && unary_allowed) {
+                current = '~';
+            }
+
+            const TArithmeticOperator& op = Operators::get(current);
+            if (op.type == TArithmeticOperator::Type::UnaryPrefix)
+            {
+                emit(TLexeme { TLexeme::Type::Number });
+            }
+
+            while (!stack.empty())
+            {
+                const TPending& stored = stack.top();
+                if (stored.type != TLexeme::Type::Operator)
+                {
+                    break;
+                }
+                const int stored_priority = Operators::priority(stored.op);
+                if (op.priority > stored_priority
+                    || (op.priority == stored_priority && op.associativity == TArithmeticOperator::Associativity::Right))
+                {
+                    break;
+                }
+                emit(stack.pop_element());
+            }
+            stack.push(TPending { TLexeme::Type::Operator, lexeme.value.as_char(), pos, TSymbolTable::NONE });
+
+            if (op.type == TArithmeticOperator::Type::UnaryPostfix)
+            {
+                emit(TLexeme { TLexeme::Type::Number });
+            }
+            break;
+        }
+        case TLexeme::Type::Function: {
+            const TSymbol symbol = TSymbolTable::global().intern(lexeme.value.as_string());
+            stack.push(TPending { TLexeme::Type::Function, '\0', pos, symbol });
+            break;
+        }
+        case TLexeme::Type::Variable:
+        case TLexeme::Type::Number: {
+            emit(lexeme);
+            break;
+        }
+        default: {
+            throw expression_parse_error("Unimplemented");
+        }
+    }
+
+    COMPILE_STATS(stats.stack_high_water = std::max<uint64_t>(stats.stack_high_water, stack.size()));
+}
+
+void TExpressionCompiler::emit(TLexeme lexeme)
+{
+    COMPILE_PHASE(Emit);
+
+    const auto pos = (uint32_t)lexeme.pos;
+    switch (lexeme.type) {
+        case TLexeme::Type::Variable: {
+            const std::string name = lexeme.value.as_string();
+            const TSymbol symbol = TSymbolTable::global().intern(name);
+            if (!Operators::has_constant(name)) {
+                target.variables.push_back(symbol);
+            }
+            target.tokens.push_back(TPostfixToken::make_symbol(TPostfixToken::Kind::Variable, symbol, pos));
+            break;
+        }
+        case TLexeme::Type::Number: {
+            // implicit operands of unary operators are empty and always succeed,
+            // so a failure here always belongs to a lexeme from the infix
+            if (!lexeme.value.reinterpret_as_number())
+            {
+                throw expression_validation_error("Malformed number: " + lexeme.value.as_string(), lexeme.pos,
+                                                  expression_validation_error::cause::BadNumber);
+            }
+            target.tokens.push_back(TPostfixToken::make_number(lexeme.value.as_number(), pos));
+            break;
+        }
+        default: {
+            throw expression_parse_error("Unimplemented");
+        }
+    }
+}
+
+void TExpressionCompiler::emit(const TPending& pending)
+{
+    COMPILE_PHASE(Emit);
+
+    switch (pending.type) {
+        case TLexeme::Type::Function: {
+            if (!Operators::supports_function(TSymbolTable::global().name(pending.symbol))) {
+                target.func_names.push_back(pending.symbol);
+            }
+            target.tokens.push_back(TPostfixToken::make_symbol(TPostfixToken::Kind::Function, pending.symbol,
+                                                               pending.pos));
+            break;
+        }
+        case TLexeme::Type::Operator: {
+            target.tokens.push_back(TPostfixToken::make_operator(pending.op, pending.pos));
+            break;
+        }
+        default: {
+            throw expression_parse_error("Unimplemented");
+        }
+    }
+}
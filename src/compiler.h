@@ -0,0 +1,70 @@
+#ifndef __COMPILER_H__
+#define __COMPILER_H__
+
+#include "postfix.h"
+#include "lexeme.h"
+#include "stack.h"
+#include "validator.h"
+#include "compile_stats.h"
+#include <chrono>
+#include <string>
+#include <string_view>
+
+// Single-pass front end: every symbol of the infix is classified once and
+// then validated, lexed and pushed through the shunting-yard in the same scan,
+// so the postfix program comes out as soon as the input is consumed
+class TExpressionCompiler {
+private:
+    TArithmeticExpression& target;
+
+    // Brackets, operators and calls waiting on the shunting-yard stack. The
+    // stack is as deep as the nesting of the input, so its entries are kept
+    // small and trivially copyable: an operator character or an interned name
+    struct TPending {
+        TLexeme::Type type;
+        char op;
+        uint32_t pos;
+        TSymbol symbol;
+    };
+
+    TInfixValidator validator;
+    TStack<TPending, 32> stack;
+
+    std::string buf;
+    TLexeme::Type buf_type = TLexeme::Type::Number;
+    size_t buf_pos = 0;
+
+    // whether a '-' met right now would be a unary one
+    bool unary_context = true;
+
+#ifdef POSTFIX_COMPILE_STATS
+    // time is charged to the current phase until the next phase switch
+    TCompileStats stats;
+    TCompileStats::Phase phase = TCompileStats::Phase::Lex;
+    std::chrono::steady_clock::time_point phase_start;
+
+    TCompileStats::Phase enter(TCompileStats::Phase next);
+
+    struct TPhaseScope;
+    struct TRecord;
+#endif
+
+    // the lexer, feeds complete lexemes to the shunting-yard
+    void lex(char c, ExpressionSymbol type);
+    void flush(char next);
+
+    void shunt(const TLexeme& lexeme);
+    void emit(TLexeme lexeme);
+    void emit(const TPending& pending);
+public:
+    explicit TExpressionCompiler(TArithmeticExpression& target);
+
+    void compile(std::string_view infix);
+};
+
+#ifdef POSTFIX_COMPILE_STATS
+// adds a finished compilation to the global and per-thread statistics
+void publish_compile_stats(const TCompileStats& stats);
+#endif
+
+#endif // __COMPILER_H__
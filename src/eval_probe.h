@@ -0,0 +1,60 @@
+#ifndef __EVAL_PROBE_H__
+#define __EVAL_PROBE_H__
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include "token.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Hooks around every token executed by the evaluator. TNoProbe compiles
+// away; TProfileProbe feeds TEvaluationProfile
+struct TNoProbe {
+    void before(size_t) {}
+    void after(size_t) {}
+};
+
+class TProfileProbe {
+public:
+    struct TCounter {
+        uint64_t count = 0;
+        uint64_t cycles = 0;
+    };
+private:
+    // keeps the counters away from a concurrent report; recursive, as
+    // user functions may evaluate expressions themselves
+    std::unique_lock<std::recursive_mutex> lock;
+    TCounter* counters;
+    uint64_t start = 0;
+
+    static uint64_t now()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+public:
+    // the profile is keyed by the infix text, which every evaluation walks
+    // token by token anyway
+    TProfileProbe(std::string_view infix, const TPostfixToken* begin, const TPostfixToken* end);
+
+    void before(size_t)
+    {
+        start = now();
+    }
+    void after(size_t idx)
+    {
+        TCounter& counter = counters[idx];
+        counter.count++;
+        counter.cycles += now() - start;
+    }
+};
+
+#endif // __EVAL_PROBE_H__
@@ -0,0 +1,327 @@
+#include "eval_profile.h"
+#include "eval_probe.h"
+#include "symbols.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <unordered_map>
+
+namespace {
+
+const size_t NO_POSITION = SIZE_MAX;
+
+// [begin, end) in the infix, empty for implicit operands
+struct TSpan {
+    size_t begin = NO_POSITION;
+    size_t end = NO_POSITION;
+
+    [[nodiscard]]
+    bool empty() const
+    {
+        return begin == NO_POSITION;
+    }
+
+    TSpan& operator|=(const TSpan& other)
+    {
+        if (other.empty())
+            return *this;
+        if (empty())
+            return *this = other;
+        begin = std::min(begin, other.begin);
+        end = std::max(end, other.end);
+        return *this;
+    }
+};
+
+struct TExpressionProfile {
+    std::string infix;
+    // per token
+    std::vector<std::string> operations;
+    std::vector<TSpan> spans;
+    std::vector<TProfileProbe::TCounter> counters;
+};
+
+struct TThreadProfile {
+    std::recursive_mutex mutex;
+    // keys view the infix of their own profile
+    std::unordered_map<std::string_view, std::unique_ptr<TExpressionProfile>> by_infix;
+};
+
+std::mutex registry_mutex;
+// profiles outlive their threads, so that the report still sees them
+std::vector<std::shared_ptr<TThreadProfile>> thread_profiles;
+
+TThreadProfile& this_thread_profile()
+{
+    thread_local const std::shared_ptr<TThreadProfile> profile = []() {
+        auto created = std::make_shared<TThreadProfile>();
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        thread_profiles.push_back(created);
+        return created;
+    }();
+    return *profile;
+}
+
+// the partner of every bracket, NO_POSITION for everything else
+std::vector<size_t> match_brackets(std::string_view infix)
+{
+    std::vector<size_t> match(infix.size(), NO_POSITION);
+    std::vector<size_t> open;
+    for (size_t i = 0; i < infix.size(); i++)
+    {
+        if (infix[i] == '(')
+        {
+            open.push_back(i);
+        }
+        else if (infix[i] == ')' && !open.empty())
+        {
+            match[i] = open.back();
+            match[open.back()] = i;
+            open.pop_back();
+        }
+    }
+    return match;
+}
+
+// Grows the span until no bracket in [from, to) has its partner outside of
+// it, checking whatever the span grows by in turn. Operand spans are balanced
+// already, so only the gaps around them need checking
+void balance(const std::vector<size_t>& match, TSpan& span, size_t from, size_t to, std::vector<TSpan>& pending)
+{
+    pending.push_back({from, to});
+    while (!pending.empty())
+    {
+        const TSpan range = pending.back();
+        pending.pop_back();
+        for (size_t i = range.begin; i < range.end; i++)
+        {
+            const size_t partner = match[i];
+            if (partner == NO_POSITION)
+                continue;
+            if (partner < span.begin)
+            {
+                pending.push_back({partner, span.begin});
+                span.begin = partner;
+            }
+            else if (partner >= span.end)
+            {
+                pending.push_back({span.end, partner + 1});
+                span.end = partner + 1;
+            }
+        }
+    }
+}
+
+std::unique_ptr<TExpressionProfile> make_profile(std::string_view infix, const TPostfixToken* begin, const TPostfixToken* end)
+{
+    auto profile = std::make_unique<TExpressionProfile>();
+    profile->infix = std::string(infix);
+    profile->counters.resize(end - begin);
+    const std::vector<size_t> match = match_brackets(infix);
+    std::vector<TSpan> pending;
+
+    // operands carry the span of the subexpression that produced them
+    std::vector<TSpan> operands;
+    for (const TPostfixToken* token = begin; token != end; token++)
+    {
+        TSpan own;
+        size_t length = 1;
+        std::string operation;
+        switch (token->kind)
+        {
+            case TPostfixToken::Kind::Number:
+                operation = "number";
+                while (token->pos > 0 && token->pos - 1 + length < infix.size()
+                       && (isdigit((unsigned char)infix[token->pos - 1 + length]) || infix[token->pos - 1 + length] == '.'))
+                {
+                    length++;
+                }
+                break;
+            case TPostfixToken::Kind::Variable:
+            case TPostfixToken::Kind::Function: {
+                const std::string& name = TSymbolTable::global().name(token->symbol);
+                operation = (token->kind == TPostfixToken::Kind::Variable ? "variable " : "function ") + name;
+                length = name.size();
+                break;
+            }
+            case TPostfixToken::Kind::Operator:
+                operation = std::string("operator ") + token->op;
+                break;
+        }
+        if (token->pos > 0)
+        {
+            own.begin = token->pos - 1;
+            own.end = own.begin + length;
+        }
+
+        // the token itself and its operands, in infix order
+        TSpan parts[3] = { own };
+        size_t count = 1;
+        const size_t arity = token->kind == TPostfixToken::Kind::Operator ? 2
+                           : token->kind == TPostfixToken::Kind::Function ? 1 : 0;
+        for (size_t k = 0; k < arity; k++)
+        {
+            parts[count++] = operands.back();
+            operands.pop_back();
+        }
+        std::sort(parts, parts + count, [](const TSpan& lhs, const TSpan& rhs) { return lhs.begin < rhs.begin; });
+
+        TSpan span;
+        for (size_t k = 0; k < count; k++)
+            span |= parts[k];
+        if (!span.empty())
+        {
+            const TSpan whole = span;
+            size_t covered = whole.begin;
+            for (size_t k = 0; k < count && !parts[k].empty(); k++)
+            {
+                balance(match, span, covered, parts[k].begin, pending);
+                covered = std::max(covered, parts[k].end);
+            }
+            balance(match, span, covered, whole.end, pending);
+        }
+        operands.push_back(span);
+
+        profile->operations.push_back(std::move(operation));
+        profile->spans.push_back(span);
+    }
+    return profile;
+}
+
+// Sums up the counters of all threads by key, then labels only the entries
+// that make it into the result. Keys see the infix as an index into infixes,
+// shared by all threads evaluating the same text
+template<class Key, class KeyOf, class LabelOf>
+std::vector<TEvaluationProfile::TEntry> hottest(size_t limit, KeyOf key_of, LabelOf label_of)
+{
+    std::unordered_map<std::string, size_t> infix_ids;
+    std::vector<const std::string*> infixes;
+    std::map<Key, TEvaluationProfile::TEntry> entries;
+
+    std::lock_guard<std::mutex> registry_lock(registry_mutex);
+    for (const auto& thread : thread_profiles)
+    {
+        std::lock_guard<std::recursive_mutex> lock(thread->mutex);
+        for (const auto& item : thread->by_infix)
+        {
+            const TExpressionProfile& profile = *item.second;
+            const auto id = infix_ids.emplace(profile.infix, infixes.size());
+            if (id.second)
+                infixes.push_back(&id.first->first);
+
+            for (size_t i = 0; i < profile.counters.size(); i++)
+            {
+                if (profile.counters[i].count == 0)
+                    continue;
+
+                Key key;
+                if (!key_of(id.first->second, profile, i, key))
+                    continue;
+
+                TEvaluationProfile::TEntry& entry = entries[key];
+                entry.count += profile.counters[i].count;
+                entry.cycles += profile.counters[i].cycles;
+            }
+        }
+    }
+
+    std::vector<typename std::map<Key, TEvaluationProfile::TEntry>::iterator> ranked;
+    ranked.reserve(entries.size());
+    for (auto item = entries.begin(); item != entries.end(); ++item)
+        ranked.push_back(item);
+    limit = std::min(limit, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + limit, ranked.end(),
+                      [](const auto& lhs, const auto& rhs) { return lhs->second.cycles > rhs->second.cycles; });
+
+    std::vector<TEvaluationProfile::TEntry> result;
+    result.reserve(limit);
+    for (size_t i = 0; i < limit; i++)
+    {
+        result.push_back(std::move(ranked[i]->second));
+        result.back().label = label_of(ranked[i]->first, infixes);
+    }
+    return result;
+}
+
+void print_table(std::string& out, const char* title, const std::vector<TEvaluationProfile::TEntry>& entries)
+{
+    char line[256];
+    snprintf(line, sizeof(line), "%s\n  %12s %14s %10s  %s\n", title, "count", "cycles", "cycles/op", "operation");
+    out += line;
+    for (const auto& entry : entries)
+    {
+        snprintf(line, sizeof(line), "  %12llu %14llu %10.1f  ", (unsigned long long)entry.count,
+                 (unsigned long long)entry.cycles, (double)entry.cycles / (double)entry.count);
+        out += line;
+        out += entry.label;
+        out += '\n';
+    }
+}
+
+}
+
+TProfileProbe::TProfileProbe(std::string_view infix, const TPostfixToken* begin, const TPostfixToken* end)
+{
+    TThreadProfile& thread = this_thread_profile();
+    lock = std::unique_lock<std::recursive_mutex>(thread.mutex);
+
+    auto known = thread.by_infix.find(infix);
+    if (known == thread.by_infix.end())
+    {
+        auto profile = make_profile(infix, begin, end);
+        const std::string_view key = profile->infix;
+        known = thread.by_infix.emplace(key, std::move(profile)).first;
+    }
+    counters = known->second->counters.data();
+}
+
+std::vector<TEvaluationProfile::TEntry> TEvaluationProfile::hottest_operations(size_t limit)
+{
+    return hottest<std::string>(
+        limit,
+        [](size_t, const TExpressionProfile& profile, size_t i, std::string& key) {
+            key = profile.operations[i];
+            return true;
+        },
+        [](const std::string& key, const std::vector<const std::string*>&) { return key; });
+}
+
+std::vector<TEvaluationProfile::TEntry> TEvaluationProfile::hottest_subexpressions(size_t limit)
+{
+    // infix, begin, end
+    using TKey = std::tuple<size_t, size_t, size_t>;
+    return hottest<TKey>(
+        limit,
+        [](size_t infix, const TExpressionProfile& profile, size_t i, TKey& key) {
+            const TSpan& span = profile.spans[i];
+            if (span.empty())
+                return false;
+            key = TKey(infix, span.begin, span.end);
+            return true;
+        },
+        [](const TKey& key, const std::vector<const std::string*>& infixes) {
+            const std::string& infix = *infixes[std::get<0>(key)];
+            return infix + ": " + infix.substr(std::get<1>(key), std::get<2>(key) - std::get<1>(key));
+        });
+}
+
+std::string TEvaluationProfile::report(size_t limit)
+{
+    std::string out;
+    print_table(out, "hottest operations:", hottest_operations(limit));
+    print_table(out, "hottest subexpressions:", hottest_subexpressions(limit));
+    return out;
+}
+
+void TEvaluationProfile::reset()
+{
+    std::lock_guard<std::mutex> registry_lock(registry_mutex);
+    for (const auto& thread : thread_profiles)
+    {
+        std::lock_guard<std::recursive_mutex> lock(thread->mutex);
+        thread->by_infix.clear();
+    }
+}
@@ -0,0 +1,104 @@
+#include "generator.h"
+#include <stdexcept>
+
+TExpressionGenerator::TExpressionGenerator(TGeneratorOptions _options, uint64_t seed)
+    : options(std::move(_options))
+    , rng(seed)
+{
+    if (options.operators.empty())
+        throw std::invalid_argument("Generator needs at least one operator");
+    if (options.functions.empty())
+        options.call_density = 0;
+}
+
+bool TExpressionGenerator::chance(double probability)
+{
+    return std::uniform_real_distribution<double>(0, 1)(rng) < probability;
+}
+
+size_t TExpressionGenerator::pick(size_t count)
+{
+    return std::uniform_int_distribution<size_t>(0, count - 1)(rng);
+}
+
+void TExpressionGenerator::append_number(std::string& infix)
+{
+    infix += std::to_string(pick(1000));
+    if (chance(0.5))
+    {
+        infix += '.';
+        infix += std::to_string(pick(100));
+    }
+}
+
+std::string TExpressionGenerator::next()
+{
+    std::string infix;
+    size_t tokens = 0;
+    size_t depth = 0;
+
+    // a unary minus is only accepted at the beginning of a group
+    const auto maybe_negate = [&]() {
+        if (chance(options.unary_minus))
+        {
+            infix += '-';
+            tokens += 2;
+        }
+    };
+
+    maybe_negate();
+    // every pass adds one operand, preceded by any groups it opens
+    while (true)
+    {
+        // open groups while allowed, each one needs an operand of its own
+        while (depth < options.max_depth && tokens < options.tokens)
+        {
+            if (chance(options.call_density))
+            {
+                infix += options.functions[pick(options.functions.size())];
+                tokens++;
+            }
+            else if (!chance(options.bracket_density))
+            {
+                break;
+            }
+            infix += '(';
+            depth++;
+            maybe_negate();
+        }
+
+        if (options.variables == 0 || chance(options.number_density))
+            append_number(infix);
+        else
+            infix += variable_name(pick(options.variables));
+        tokens++;
+
+        while (depth > 0 && (tokens >= options.tokens || chance(options.close_density)))
+        {
+            infix += ')';
+            depth--;
+        }
+        if (tokens >= options.tokens && depth == 0)
+            break;
+
+        infix += options.operators[pick(options.operators.size())];
+        tokens++;
+    }
+
+    return infix;
+}
+
+std::string TExpressionGenerator::variable_name(size_t idx)
+{
+    return "v" + std::to_string(idx);
+}
+
+std::vector<std::string> TExpressionGenerator::variable_names() const
+{
+    std::vector<std::string> names;
+    for (size_t i = 0; i < options.variables; i++)
+    {
+        names.push_back(variable_name(i));
+    }
+    return names;
+}
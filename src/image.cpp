@@ -0,0 +1,409 @@
+#include "image.h"
+#include "operators.h"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+namespace {
+
+const char MAGIC[4] = { 'P', 'F', 'X', 'I' };
+const size_t HEADER_SIZE = 24;
+const size_t CHECKSUM_OFFSET = 16;
+const size_t TOKEN_SIZE = 16;
+// entry size, name length and infix length
+const size_t MIN_ENTRY_SIZE = 12;
+
+uint64_t fnv1a(std::string_view data, uint64_t hash = 14695981039346656037ull)
+{
+    for (const char c : data)
+    {
+        hash ^= (unsigned char)c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// everything but the checksum itself; version 2 and older left the header out
+uint64_t checksum(std::string_view image, uint32_t version)
+{
+    const uint64_t header = version > 2 ? fnv1a(image.substr(0, CHECKSUM_OFFSET)) : fnv1a({});
+    return fnv1a(image.substr(HEADER_SIZE), header);
+}
+
+class TWriter {
+private:
+    std::string& out;
+public:
+    explicit TWriter(std::string& out)
+        : out(out)
+    {}
+
+    void u8(uint8_t v)
+    {
+        out += (char)v;
+    }
+    void u16(uint16_t v)
+    {
+        for (int i = 0; i < 2; i++)
+            u8((uint8_t)(v >> (8 * i)));
+    }
+    void u32(uint32_t v)
+    {
+        for (int i = 0; i < 4; i++)
+            u8((uint8_t)(v >> (8 * i)));
+    }
+    void u64(uint64_t v)
+    {
+        for (int i = 0; i < 8; i++)
+            u8((uint8_t)(v >> (8 * i)));
+    }
+    void f64(double v)
+    {
+        uint64_t bits;
+        memcpy(&bits, &v, sizeof(bits));
+        u64(bits);
+    }
+    void bytes(std::string_view s)
+    {
+        out.append(s.data(), s.size());
+    }
+    void align(size_t alignment)
+    {
+        while (out.size() % alignment != 0)
+            u8(0);
+    }
+
+    [[nodiscard]] size_t size() const { return out.size(); }
+
+    void patch_u32(size_t offset, uint32_t v)
+    {
+        for (int i = 0; i < 4; i++)
+            out[offset + i] = (char)(uint8_t)(v >> (8 * i));
+    }
+};
+
+class TReader {
+private:
+    std::string_view data;
+    size_t offset;
+
+    void require(size_t n) const
+    {
+        if (data.size() - offset < n)
+            throw expression_image_error("Truncated expression image");
+    }
+public:
+    TReader(std::string_view data, size_t offset)
+        : data(data)
+        , offset(offset)
+    {}
+
+    uint8_t u8()
+    {
+        require(1);
+        return (uint8_t)data[offset++];
+    }
+    uint16_t u16()
+    {
+        uint16_t v = 0;
+        for (int i = 0; i < 2; i++)
+            v |= (uint16_t)u8() << (8 * i);
+        return v;
+    }
+    uint32_t u32()
+    {
+        uint32_t v = 0;
+        for (int i = 0; i < 4; i++)
+            v |= (uint32_t)u8() << (8 * i);
+        return v;
+    }
+    uint64_t u64()
+    {
+        uint64_t v = 0;
+        for (int i = 0; i < 8; i++)
+            v |= (uint64_t)u8() << (8 * i);
+        return v;
+    }
+    double f64()
+    {
+        const uint64_t bits = u64();
+        double v;
+        memcpy(&v, &bits, sizeof(v));
+        return v;
+    }
+    std::string_view bytes(size_t n)
+    {
+        require(n);
+        const std::string_view s = data.substr(offset, n);
+        offset += n;
+        return s;
+    }
+    void align(size_t alignment)
+    {
+        while (offset % alignment != 0)
+            u8();
+    }
+
+    [[nodiscard]] size_t position() const { return offset; }
+};
+
+bool host_is_little_endian()
+{
+    const uint16_t probe = 1;
+    uint8_t first;
+    memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+// token records share the in-memory layout of TPostfixToken on little-endian hosts
+TPostfixToken read_token(const char* record)
+{
+    static_assert(sizeof(TPostfixToken) == TOKEN_SIZE, "Token records should match the token layout");
+
+    TPostfixToken token;
+    if (host_is_little_endian())
+    {
+        memcpy(&token, record, TOKEN_SIZE);
+        return token;
+    }
+
+    TReader reader(std::string_view(record, TOKEN_SIZE), 0);
+    token = { (TPostfixToken::Kind)reader.u8(), {}, 0, {} };
+    reader.u8();
+    reader.u16();
+    token.pos = reader.u32();
+    switch (token.kind)
+    {
+        case TPostfixToken::Kind::Number:
+            token.number = reader.f64();
+            break;
+        case TPostfixToken::Kind::Operator:
+            token.op = (char)reader.u8();
+            break;
+        default:
+            token.symbol = reader.u32();
+            break;
+    }
+    return token;
+}
+
+}
+
+std::string TExpressionImage::encode(const std::vector<TEntry>& entries)
+{
+    std::string image;
+    TWriter writer(image);
+
+    writer.bytes(std::string_view(MAGIC, sizeof(MAGIC)));
+    writer.u32(VERSION);
+    writer.u32((uint32_t)entries.size());
+    writer.u32(0);
+    writer.u64(0); // checksum, patched below
+
+    for (const auto& entry : entries)
+    {
+        const TArithmeticExpression& expr = *entry.expression;
+
+        const size_t size_offset = writer.size();
+        writer.u32(0);
+        writer.u32((uint32_t)entry.name.size());
+        writer.u32((uint32_t)expr.infix.size());
+        writer.bytes(entry.name);
+        writer.bytes(expr.infix);
+
+        // string table: the names of variables and functions
+        std::vector<std::string> strings;
+        std::unordered_map<std::string, uint32_t> string_index;
+        const auto intern = [&](const std::string& s) {
+            const auto it = string_index.find(s);
+            if (it != string_index.end())
+                return it->second;
+            strings.push_back(s);
+            return string_index[s] = (uint32_t)(strings.size() - 1);
+        };
+
+        std::vector<uint32_t> variables, functions;
+        for (const TSymbol symbol : expr.variables)
+            variables.push_back(intern(TSymbolTable::global().name(symbol)));
+        for (const TSymbol symbol : expr.func_names)
+            functions.push_back(intern(TSymbolTable::global().name(symbol)));
+        // constants are named by tokens without being variables
+        for (const auto& token : expr.tokens)
+        {
+            if (token.kind == TPostfixToken::Kind::Variable || token.kind == TPostfixToken::Kind::Function)
+                intern(TSymbolTable::global().name(token.symbol));
+        }
+
+        writer.u32((uint32_t)strings.size());
+        for (const auto& s : strings)
+        {
+            writer.u32((uint32_t)s.size());
+            writer.bytes(s);
+        }
+        writer.u32((uint32_t)variables.size());
+        for (const uint32_t idx : variables)
+            writer.u32(idx);
+        writer.u32((uint32_t)functions.size());
+        for (const uint32_t idx : functions)
+            writer.u32(idx);
+
+        writer.u32((uint32_t)expr.tokens.size());
+        writer.align(8);
+        for (const auto& token : expr.tokens)
+        {
+            writer.u8((uint8_t)token.kind);
+            writer.u8(0);
+            writer.u16(0);
+            writer.u32(token.pos);
+            switch (token.kind)
+            {
+                case TPostfixToken::Kind::Number:
+                    writer.f64(token.number);
+                    break;
+                case TPostfixToken::Kind::Operator:
+                    writer.u8((uint8_t)token.op);
+                    writer.u8(0);
+                    writer.u16(0);
+                    writer.u32(0);
+                    break;
+                default:
+                    writer.u32(intern(TSymbolTable::global().name(token.symbol)));
+                    writer.u32(0);
+                    break;
+            }
+        }
+        writer.align(8);
+
+        writer.patch_u32(size_offset, (uint32_t)(writer.size() - size_offset - 4));
+    }
+
+    const uint64_t sum = checksum(image, VERSION);
+    for (int i = 0; i < 8; i++)
+        image[CHECKSUM_OFFSET + i] = (char)(uint8_t)(sum >> (8 * i));
+
+    return image;
+}
+
+std::vector<TExpressionImage::TEntry> TExpressionImage::decode(std::string_view image, bool* recompiled)
+{
+    TReader header(image, 0);
+    if (header.bytes(sizeof(MAGIC)) != std::string_view(MAGIC, sizeof(MAGIC)))
+        throw expression_image_error("Not an expression image");
+
+    const uint32_t version = header.u32();
+    const uint32_t count = header.u32();
+    header.u32();
+    const uint64_t sum = header.u64();
+
+    if (checksum(image, version) != sum)
+        throw expression_image_error("Expression image checksum mismatch");
+    if (count > (image.size() - HEADER_SIZE) / MIN_ENTRY_SIZE)
+        throw expression_image_error("Entry count does not fit the expression image");
+
+    if (recompiled)
+        *recompiled = version != VERSION;
+
+    std::vector<TEntry> entries;
+    entries.reserve(count);
+
+    TReader reader(image, HEADER_SIZE);
+    for (uint32_t e = 0; e < count; e++)
+    {
+        const uint32_t entry_size = reader.u32();
+        const size_t entry_end = reader.position() + entry_size;
+
+        const uint32_t name_length = reader.u32();
+        const uint32_t infix_length = reader.u32();
+        std::string name(reader.bytes(name_length));
+        std::string infix(reader.bytes(infix_length));
+
+        if (version != VERSION)
+        {
+            entries.push_back({ std::move(name), std::make_shared<const TArithmeticExpression>(infix) });
+            reader.bytes(entry_end - reader.position());
+            continue;
+        }
+
+        auto expr = std::shared_ptr<TArithmeticExpression>(
+                new TArithmeticExpression(TArithmeticExpression::restore_tag{}, std::move(infix)));
+
+        std::vector<std::string_view> strings(reader.u32());
+        for (auto& s : strings)
+            s = reader.bytes(reader.u32());
+
+        const auto symbol_at = [&strings](uint32_t idx) {
+            if (idx >= strings.size())
+                throw expression_image_error("Bad string index in expression image");
+            return TSymbolTable::global().intern(strings[idx]);
+        };
+
+        for (uint32_t n = reader.u32(); n > 0; n--)
+            expr->variables.push_back(symbol_at(reader.u32()));
+        for (uint32_t n = reader.u32(); n > 0; n--)
+            expr->func_names.push_back(symbol_at(reader.u32()));
+        // symbol ids differ between processes, restore the order the program relies on
+        std::sort(expr->variables.begin(), expr->variables.end());
+        std::sort(expr->func_names.begin(), expr->func_names.end());
+
+        // the postfix text is rebuilt from the program when asked for
+        const uint32_t token_count = reader.u32();
+        reader.align(8);
+        const std::string_view records = reader.bytes((size_t)token_count * TOKEN_SIZE);
+        for (uint32_t t = 0; t < token_count; t++)
+        {
+            TPostfixToken token = read_token(records.data() + t * TOKEN_SIZE);
+            switch (token.kind)
+            {
+                case TPostfixToken::Kind::Number:
+                case TPostfixToken::Kind::Operator:
+                    break;
+                // evaluation only checks the listed names are bound, so every
+                // other name has to be a built-in one
+                case TPostfixToken::Kind::Variable:
+                    token.symbol = symbol_at(token.symbol);
+                    if (!std::binary_search(expr->variables.begin(), expr->variables.end(), token.symbol)
+                        && !Operators::has_constant(TSymbolTable::global().name(token.symbol)))
+                    {
+                        throw expression_image_error("Unlisted variable in expression image");
+                    }
+                    break;
+                case TPostfixToken::Kind::Function:
+                    token.symbol = symbol_at(token.symbol);
+                    if (!std::binary_search(expr->func_names.begin(), expr->func_names.end(), token.symbol)
+                        && !Operators::supports_function(TSymbolTable::global().name(token.symbol)))
+                    {
+                        throw expression_image_error("Unlisted function in expression image");
+                    }
+                    break;
+                default:
+                    throw expression_image_error("Bad token in expression image");
+            }
+            expr->tokens.push_back(token);
+        }
+        reader.align(8);
+
+        if (reader.position() != entry_end)
+            throw expression_image_error("Malformed expression image entry");
+        if (!expr->verify_program())
+            throw expression_image_error("Unbalanced program in expression image");
+
+        entries.push_back({ std::move(name), std::move(expr) });
+    }
+
+    return entries;
+}
+
+std::string TExpressionImage::encode(const TArithmeticExpression& expression)
+{
+    // the image only needs the expression for the duration of the call
+    const std::shared_ptr<const TArithmeticExpression> borrowed(&expression, [](const TArithmeticExpression*) {});
+    return encode({ { "", borrowed } });
+}
+
+TArithmeticExpression TExpressionImage::decode_single(std::string_view image)
+{
+    const auto entries = decode(image);
+    if (entries.size() != 1)
+        throw expression_image_error("Expected a single expression in the image");
+    return *entries.front().expression;
+}
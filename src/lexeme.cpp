@@ -1,5 +1,6 @@
 #include "lexeme.h"
 #include <stdexcept>
+#include <charconv>
 
 TLexemeValue::TLexemeValue(std::string str)
         : str(std::move(str))
@@ -33,11 +34,14 @@ bool TLexemeValue::reinterpret_as_number()
 {
     if (!str.empty())
     {
-        try {
-            numeric = std::stod(str);
-        } catch (...) {
+        // std::from_chars is locale-independent and reports failures
+        // through its result instead of throwing
+        const char* const first = str.data();
+        const char* const last = first + str.size();
+
+        const auto result = std::from_chars(first, last, numeric);
+        if (result.ec != std::errc() || result.ptr != last)
             return false;
-        }
 
         str.resize(0);
     }
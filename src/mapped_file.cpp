@@ -0,0 +1,195 @@
+#include "mapped_file.h"
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+TMappedFile::TMappedFile(const std::string& path)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Cannot open file: " + path);
+
+    struct stat st {};
+    if (fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        throw std::runtime_error("Cannot stat file: " + path);
+    }
+
+    length = (size_t)st.st_size;
+    if (length > 0)
+    {
+        void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            ::close(fd);
+            throw std::runtime_error("Cannot map file: " + path);
+        }
+        madvise(mapping, length, MADV_SEQUENTIAL);
+
+        pData = static_cast<const char*>(mapping);
+        handle = mapping;
+    }
+    ::close(fd);
+}
+
+void TMappedFile::release() noexcept
+{
+    if (handle)
+        munmap(handle, length);
+}
+
+TMappedOutputFile::TMappedOutputFile(const std::string& path, size_t size)
+    : length(size)
+    , path(path)
+{
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        throw std::runtime_error("Cannot create file: " + path);
+
+    if (ftruncate(fd, (off_t)size) != 0)
+    {
+        ::close(fd);
+        throw std::runtime_error("Cannot resize file: " + path);
+    }
+
+    if (length > 0)
+    {
+        void* mapping = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            ::close(fd);
+            throw std::runtime_error("Cannot map file: " + path);
+        }
+
+        pData = static_cast<char*>(mapping);
+        handle = mapping;
+    }
+    ::close(fd);
+}
+
+// the written pages already belong to the file, unmapping is all that is left
+void TMappedOutputFile::close()
+{
+    if (handle == nullptr)
+        return;
+
+    const int result = munmap(handle, length);
+    handle = nullptr;
+    pData = nullptr;
+    if (result != 0)
+        throw std::runtime_error("Cannot unmap file: " + path);
+}
+
+void TMappedOutputFile::release() noexcept
+{
+    if (handle)
+        munmap(handle, length);
+    handle = nullptr;
+}
+#else
+#include <fstream>
+
+TMappedFile::TMappedFile(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in)
+        throw std::runtime_error("Cannot open file: " + path);
+
+    length = (size_t)in.tellg();
+    char* buffer = new char[length > 0 ? length : 1];
+    in.seekg(0);
+    in.read(buffer, (std::streamsize)length);
+
+    pData = buffer;
+    handle = buffer;
+}
+
+void TMappedFile::release() noexcept
+{
+    delete[] static_cast<char*>(handle);
+}
+
+TMappedOutputFile::TMappedOutputFile(const std::string& path, size_t size)
+    : length(size)
+    , path(path)
+{
+    if (!std::ofstream(path, std::ios::binary | std::ios::trunc))
+        throw std::runtime_error("Cannot create file: " + path);
+
+    // zero filled, as a freshly extended file would be
+    pData = new char[length > 0 ? length : 1]();
+    handle = pData;
+}
+
+void TMappedOutputFile::close()
+{
+    if (handle == nullptr)
+        return;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(pData, (std::streamsize)length);
+    const bool written = out.good();
+    release();
+    pData = nullptr;
+    if (!written)
+        throw std::runtime_error("Cannot write file: " + path);
+}
+
+void TMappedOutputFile::release() noexcept
+{
+    delete[] static_cast<char*>(handle);
+    handle = nullptr;
+}
+#endif
+
+TMappedFile::TMappedFile(TMappedFile&& src) noexcept
+{
+    std::swap(pData, src.pData);
+    std::swap(length, src.length);
+    std::swap(handle, src.handle);
+}
+
+TMappedFile& TMappedFile::operator=(TMappedFile&& src) noexcept
+{
+    std::swap(pData, src.pData);
+    std::swap(length, src.length);
+    std::swap(handle, src.handle);
+    return *this;
+}
+
+TMappedFile::~TMappedFile()
+{
+    release();
+}
+
+TMappedOutputFile::TMappedOutputFile(TMappedOutputFile&& src) noexcept
+{
+    std::swap(pData, src.pData);
+    std::swap(length, src.length);
+    std::swap(handle, src.handle);
+    std::swap(path, src.path);
+}
+
+TMappedOutputFile& TMappedOutputFile::operator=(TMappedOutputFile&& src) noexcept
+{
+    std::swap(pData, src.pData);
+    std::swap(length, src.length);
+    std::swap(handle, src.handle);
+    std::swap(path, src.path);
+    return *this;
+}
+
+TMappedOutputFile::~TMappedOutputFile()
+{
+    try {
+        close();
+    } catch (...) {
+        release();
+    }
+}
@@ -1,24 +1,6 @@
 #include "operators.h"
 #include <cmath>
 
-const std::map<char, TArithmeticOperator> Operators::LIST = {
-        { '+', { 2, std::plus<>{} } },
-        { '-', { 2, std::minus<>{} } },
-        { '*', { 3, std::multiplies<>{} } },
-        { '/', { 3, std::divides<>{} } },
-        { '%', { 3, [](double a, double b) { return (long)a % (long)b; } } },
-        { '^', { 3, [](double a, double b) { return pow(a, b); } } },
-        { '~', { 4, [](double _, double x) { return -x; }, TArithmeticOperator::Type::UnaryPrefix } },
-        { '!', { 4, [](double x, double _) {
-            const long lim = (long)x;
-            double res = 1;
-            for (long i = 1; i <= lim; ++i)
-            {
-                res *= i;
-            }
-            return res;
-        }, TArithmeticOperator::Type::UnaryPostfix } },
-};
 const std::map<std::string, double> Operators::CONSTANTS = {
         { "pi", 3.14159 }
 };
@@ -2,26 +2,67 @@
 #define __OPERATORS_H__
 
 #include "postfix.h"
+#include <array>
+#include <cmath>
+#include <cstdint>
 #include <map>
-#include <functional>
 
 struct TArithmeticOperator
 {
-    int priority;
-    std::function<double (double, double)> handler;
-    enum class Type {
+    int priority = 0;
+    enum class Type : uint8_t {
         Standard,
         UnaryPrefix,
         UnaryPostfix
     } type = Type::Standard;
+    enum class Associativity : uint8_t {
+        Left,
+        Right
+    } associativity = Associativity::Left;
+    // what calculate executes for the operator, None for non-operator symbols
+    enum class Kernel : uint8_t {
+        None,
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        Modulo,
+        Power,
+        Negate,
+        Factorial
+    } kernel = Kernel::None;
+
+    [[nodiscard]]
+    constexpr int arity() const
+    {
+        return type == Type::Standard ? 2 : 1;
+    }
 };
 
+constexpr std::array<TArithmeticOperator, 256> make_operator_table()
+{
+    using Op = TArithmeticOperator;
+
+    std::array<TArithmeticOperator, 256> table {};
+    table['+'] = { 2, Op::Type::Standard, Op::Associativity::Left, Op::Kernel::Add };
+    table['-'] = { 2, Op::Type::Standard, Op::Associativity::Left, Op::Kernel::Subtract };
+    table['*'] = { 3, Op::Type::Standard, Op::Associativity::Left, Op::Kernel::Multiply };
+    table['/'] = { 3, Op::Type::Standard, Op::Associativity::Left, Op::Kernel::Divide };
+    table['%'] = { 3, Op::Type::Standard, Op::Associativity::Left, Op::Kernel::Modulo };
+    table['^'] = { 3, Op::Type::Standard, Op::Associativity::Left, Op::Kernel::Power };
+    table['~'] = { 4, Op::Type::UnaryPrefix, Op::Associativity::Left, Op::Kernel::Negate };
+    table['!'] = { 4, Op::Type::UnaryPostfix, Op::Associativity::Left, Op::Kernel::Factorial };
+    return table;
+}
+
 class Operators
 {
 public:
     Operators() = delete;
 
-    static const std::map<char, TArithmeticOperator> LIST;
+    // indexed by the operator symbol, entries of other symbols have Kernel::None
+    static constexpr std::array<TArithmeticOperator, 256> TABLE = make_operator_table();
+
     static const std::map<std::string, double> CONSTANTS;
     static const std::map<std::string, std::shared_ptr<TArithmeticExpressionFunction>> STD_FUNCTIONS;
 
@@ -35,26 +76,70 @@ public:
         return CONSTANTS.find(name) != CONSTANTS.end();
     }
 
-    static int priority(const char c)
+    static constexpr const TArithmeticOperator& get(char c)
     {
-        if (is_bracket(c)) return 0;
-        return LIST.at(c).priority;
+        return TABLE[(unsigned char)c];
     }
 
-    static bool is_operator(char c)
+    static constexpr int priority(const char c)
     {
-        return LIST.find(c) != LIST.end();
+        return get(c).priority;
     }
 
-    static bool is_bracket(char c)
+    static constexpr bool is_operator(char c)
+    {
+        return get(c).kernel != TArithmeticOperator::Kernel::None;
+    }
+
+    static constexpr bool is_bracket(char c)
     {
         return c == '(' || c == ')';
     }
 
-    static bool is_service_symbol(char c)
+    static constexpr bool is_service_symbol(char c)
     {
         return is_bracket(c) || is_operator(c);
     }
+
+    // unary operators receive their implicit zero operand as the other argument
+    static double apply(TArithmeticOperator::Kernel kernel, double a, double b)
+    {
+        switch (kernel)
+        {
+            case TArithmeticOperator::Kernel::Add:
+                return a + b;
+            case TArithmeticOperator::Kernel::Subtract:
+                return a - b;
+            case TArithmeticOperator::Kernel::Multiply:
+                return a * b;
+            case TArithmeticOperator::Kernel::Divide:
+                return a / b;
+            case TArithmeticOperator::Kernel::Modulo:
+                // the integer remainder without its traps: nan for a zero,
+                // infinite or nan operand instead of a division fault
+                return std::fmod(std::trunc(a), std::trunc(b));
+            case TArithmeticOperator::Kernel::Power:
+                return pow(a, b);
+            case TArithmeticOperator::Kernel::Negate:
+                return -b;
+            case TArithmeticOperator::Kernel::Factorial: {
+                // 171! is beyond a double, larger arguments would only burn time
+                if (std::isnan(a))
+                    return a;
+                if (a > 170)
+                    return HUGE_VAL;
+                const long lim = (long)a;
+                double res = 1;
+                for (long i = 1; i <= lim; ++i)
+                {
+                    res *= i;
+                }
+                return res;
+            }
+            default:
+                throw std::runtime_error("Unimplemented");
+        }
+    }
 };
 
 #endif // __OPERATORS_H__
@@ -0,0 +1,125 @@
+#include "parallel.h"
+#include <algorithm>
+
+// set on pool workers, and on a caller while it runs chunks of its own call:
+// lets nested parallel_for calls run inline instead of deadlocking
+static thread_local bool in_parallel_for = false;
+
+TThreadPool::TThreadPool(size_t threads)
+{
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+
+    workers.reserve(threads - 1);
+    for (size_t i = 1; i < threads; i++)
+    {
+        workers.emplace_back(&TThreadPool::work, this);
+    }
+}
+
+TThreadPool::~TThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void TThreadPool::work()
+{
+    in_parallel_for = true;
+
+    size_t seen = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&]() { return stopping || generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+        }
+
+        run_chunks();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--active == 0)
+            done.notify_all();
+    }
+}
+
+void TThreadPool::run_chunks()
+{
+    while (true)
+    {
+        const size_t begin = next.fetch_add(job_grain);
+        if (begin >= job_count)
+            return;
+
+        const size_t end = std::min(begin + job_grain, job_count);
+        try {
+            (*job)(begin, end);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!failure)
+                failure = std::current_exception();
+            // drain the remaining chunks
+            next = job_count;
+        }
+    }
+}
+
+void TThreadPool::parallel_for(size_t count, size_t grain, const std::function<void (size_t, size_t)>& body)
+{
+    if (count == 0)
+        return;
+    if (grain == 0)
+        grain = 1;
+
+    if (workers.empty() || in_parallel_for || count <= grain)
+    {
+        for (size_t begin = 0; begin < count; begin += grain)
+        {
+            body(begin, std::min(begin + grain, count));
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> submit(submit_mutex);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &body;
+        job_count = count;
+        job_grain = grain;
+        next = 0;
+        failure = nullptr;
+        active = workers.size();
+        generation++;
+    }
+    wake.notify_all();
+
+    in_parallel_for = true;
+    run_chunks();
+    in_parallel_for = false;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&]() { return active == 0; });
+    job = nullptr;
+
+    if (failure)
+        std::rethrow_exception(failure);
+}
+
+TThreadPool& TThreadPool::shared()
+{
+    static TThreadPool pool;
+    return pool;
+}
@@ -2,259 +2,373 @@
 #include "stack.h"
 #include "lexeme.h"
 #include "operators.h"
-#include "validator.h"
+#include "compiler.h"
+#include "eval_probe.h"
 #include <algorithm>
-
-TDynamicList<TLexeme> tokenize(const std::string& infix)
+#include <cassert>
+
+TArithmeticExpression::TArithmeticExpression(std::string_view infix)
+    : TArithmeticExpression(infix, nullptr)
+{}
+
+// the lists fall back to operator new on their own, the std::pmr containers need
+// an actual resource
+TArithmeticExpression::TArithmeticExpression(std::string_view infix, std::pmr::memory_resource* arena)
+    : infix(infix, arena != nullptr ? arena : std::pmr::get_default_resource())
+    , tokens(8, arena)
+    , variables(this->infix.get_allocator())
+    , func_names(this->infix.get_allocator())
 {
-    TDynamicList<TLexeme> result;
+    TExpressionCompiler(*this).compile(infix);
+}
 
-    TLexeme lex = { TLexeme::Type::Number, TLexemeValue() };
-    std::string buf;
+TArithmeticExpression::TArithmeticExpression(restore_tag, std::string infix)
+    : infix(infix)
+{}
 
-    for (const char& c : infix)
-    {
-        if (isspace(c))
-            continue;
-
-        if (Operators::is_service_symbol(c))
-        {
-            if (!buf.empty())
-            {
-                lex.value = TLexemeValue(buf);
-                result.push_back(lex);
-            }
-
-            lex.type = Operators::is_bracket(c) ? TLexeme::Type::Bracket : TLexeme::Type::Operator;
-            lex.value = TLexemeValue(std::string{c});
-            if (lex.type == TLexeme::Type::Bracket && lex.value.as_char() == '('
-                && result.tail().type == TLexeme::Type::Variable)
-            {
-                result.tail().type = TLexeme::Type::Function;
-            }
-            result.push_back(lex);
-
-            lex.type = TLexeme::Type::Number;
+std::string TArithmeticExpression::get_infix() const
+{
+    return std::string(infix);
+}
 
-            buf = "";
-            continue;
-        }
+// numbers are taken from the infix as written
+// the lexer joins the digits of a number across spaces, the text leaves them out
+static void append_number_text(std::string& out, std::string_view infix, uint32_t pos)
+{
+    if (pos == 0)
+        return;
 
-        buf += c;
-        if (lex.type == TLexeme::Type::Number && (!isdigit(c) && c != '.'))
-            lex.type = TLexeme::Type::Variable;
-    }
-    if (!buf.empty())
+    for (size_t i = pos - 1; i < infix.size(); i++)
     {
-        lex.value = TLexemeValue(buf);
-        result.push_back(lex);
+        const ExpressionSymbol type = get_type(infix[i]);
+        if (type == ExpressionSymbol::Digit || type == ExpressionSymbol::Dot)
+            out += infix[i];
+        else if (type != ExpressionSymbol::Space)
+            break;
     }
-
-    return result;
 }
 
-TDynamicList<TLexeme> to_postfix(const TDynamicList<TLexeme>& lexemes)
+static std::vector<std::string_view> sorted_names(const std::pmr::vector<TSymbol>& symbols)
 {
-    TDynamicList<TLexeme> postfix(lexemes.size());
-    TStack<TLexeme> stack((lexemes.size() / 2) + 1);
-
-    size_t i = 0;
-    for (const auto& lexeme : lexemes)
+    std::vector<std::string_view> names;
+    names.reserve(symbols.size());
+    for (const TSymbol symbol : symbols)
     {
-        switch (lexeme.type)
-        {
-            case TLexeme::Type::Bracket: {
-                if (lexeme.value.as_char() == '(')
-                {
-                    stack.push(lexeme);
-                }
-                else // lexeme.value.as_char() == ')'
-                {
-                    while (stack.top().value.as_char() != '(') {
-                        postfix.push_back(stack.top());
-                        stack.pop();
-                    }
-                    stack.pop();
-
-                    if (!stack.empty() && stack.top().type == TLexeme::Type::Function)
-                    {
-                        postfix.push_back(stack.pop_element());
-                    }
-                }
-                break;
-            }
-            case TLexeme::Type::Operator: {
-                char current = lexeme.value.as_char();
-                if (current == '-' && (i == 0 || lexemes[i - 1].value.as_char() == '(')) {
-                    current = '~';
-                }
+        names.emplace_back(TSymbolTable::global().name(symbol));
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
 
-                const auto& op_type = Operators::LIST.at(current).type;
-                if (op_type == TArithmeticOperator::Type::UnaryPrefix)
-                {
-                    postfix.push_back(TLexeme { TLexeme::Type::Number });
-                }
+std::shared_ptr<const TArithmeticExpression::TText> TArithmeticExpression::make_text() const
+{
+    // built in place, the views must not see the text move
+    auto shared = std::make_shared<TText>();
+    TText& result = *shared;
 
-                while (!stack.empty())
-                {
-                    const TLexeme& stored = stack.top();
-                    if (stored.type != TLexeme::Type::Operator || Operators::priority(current) > Operators::priority(stored.value.as_char()))
-                    {
-                        break;
-                    }
-                    postfix.push_back(stored);
-                    stack.pop();
-                }
-                stack.push(lexeme);
+    std::vector<size_t> ends;
+    ends.reserve(tokens.size());
+    for (const auto& token : tokens)
+    {
+        if (!ends.empty())
+            result.postfix += POSTFIX_LEXEME_SEPARATOR;
 
-                if (op_type == TArithmeticOperator::Type::UnaryPostfix)
-                {
-                    postfix.push_back(TLexeme { TLexeme::Type::Number });
-                }
+        switch (token.kind)
+        {
+            case TPostfixToken::Kind::Number:
+                append_number_text(result.postfix, infix, token.pos);
                 break;
-            }
-            case TLexeme::Type::Function: {
-                stack.push(lexeme);
+            case TPostfixToken::Kind::Variable:
+            case TPostfixToken::Kind::Function:
+                result.postfix += TSymbolTable::global().name(token.symbol);
                 break;
-            }
-            case TLexeme::Type::Variable:
-            case TLexeme::Type::Number: {
-                postfix.push_back(lexeme);
+            case TPostfixToken::Kind::Operator:
+                result.postfix += token.op;
                 break;
-            }
-            default: {
-                throw expression_parse_error("Unimplemented");
-            }
         }
-
-        i++;
+        ends.push_back(result.postfix.size());
     }
 
-    while (!stack.empty())
+    // the text is complete, so the views into it stay valid
+    result.lexemes.reserve(ends.size());
+    size_t start = 0;
+    for (const size_t end : ends)
     {
-        postfix.push_back(stack.pop_element());
+        result.lexemes.emplace_back(result.postfix.data() + start, end - start);
+        start = end + 1;
     }
 
-    return postfix;
-}
-
-TArithmeticExpression::TArithmeticExpression(const std::string& infix)
-    : infix(validate_infix(infix))
-    , tokens(to_postfix(tokenize(infix)))
-{
-    //
-    for (auto& token : tokens)
-    {
-        postfix.push_back(token.value.as_string());
-
-        switch (token.type) {
-            case TLexeme::Type::Function: {
-                const std::string& name = token.value.as_string();
-                if (!Operators::supports_function(name)) {
-                    func_names.insert(name);
-                }
-                break;
-            }
-            case TLexeme::Type::Variable: {
-                const std::string& name = token.value.as_string();
-                if (!Operators::has_constant(name)) {
-                    variables.insert(name);
-                }
-                break;
-            }
-            case TLexeme::Type::Number: {
-                if (!token.value.reinterpret_as_number())
-                {
-                    throw expression_parse_error("Failed to parse numeric token: " + token.value.as_string());
-                }
-                break;
-            }
-        }
-    }
-    //
+    result.variables = sorted_names(variables);
+    result.functions = sorted_names(func_names);
+    return shared;
 }
 
-std::string TArithmeticExpression::get_infix() const
+TListView<std::string_view> TArithmeticExpression::get_postfix() const
 {
-    return infix;
+    const auto& lexemes = text.get([this] { return make_text(); }).lexemes;
+    return { lexemes.data(), lexemes.data() + lexemes.size() };
 }
-TDynamicList<std::string> TArithmeticExpression::get_postfix() const
+std::string_view TArithmeticExpression::get_postfix_text() const
 {
-    return postfix;
+    return text.get([this] { return make_text(); }).postfix;
 }
 
-std::set<std::string> TArithmeticExpression::get_variables() const
-{
-    return variables;
-}
-std::set<std::string> TArithmeticExpression::get_functions() const
+template<class String>
+static size_t heap_size(const String& s)
 {
-    return func_names;
+    // short strings live inside the object itself
+    const char* data = s.data();
+    const bool inline_storage = data >= (const char*)&s && data < (const char*)(&s + 1);
+    return inline_storage ? 0 : s.capacity() + 1;
 }
 
-
-template<typename K, typename V>
-void left_join(const std::map<K, V> left, const std::map<K, V> right)
+size_t TArithmeticExpression::memory_usage() const
 {
-    for (const auto& r_pair : right)
+    size_t bytes = sizeof(*this) + heap_size(infix);
+
+    if (const TText* materialized = text.peek())
     {
-        const auto& l_pair = left.find(r_pair.first);
-        if (l_pair == left.end()) continue;
-        (*l_pair).second = r_pair.second;
+        bytes += sizeof(TText) + heap_size(materialized->postfix);
+        bytes += (materialized->lexemes.capacity() + materialized->variables.capacity()
+                  + materialized->functions.capacity()) * sizeof(std::string_view);
     }
+
+    bytes += tokens.allocated_bytes();
+    bytes += (variables.capacity() + func_names.capacity()) * sizeof(TSymbol);
+
+    return bytes;
 }
 
-template<typename K, typename V>
-bool require_keys(const std::map<K, V>& map, const std::set<K>& keys)
+TListView<std::string_view> TArithmeticExpression::get_variables() const
 {
-    return std::all_of(keys.begin(), keys.end(), [&map](K key) { return map.find(key) != map.end(); });
+    const auto& names = text.get([this] { return make_text(); }).variables;
+    return { names.data(), names.data() + names.size() };
+}
+TListView<std::string_view> TArithmeticExpression::get_functions() const
+{
+    const auto& names = text.get([this] { return make_text(); }).functions;
+    return { names.data(), names.data() + names.size() };
 }
 
 double TArithmeticExpression::calculate(const std::map<std::string, double>& _values,
                                         const std::map<std::string, std::shared_ptr<TArithmeticExpressionFunction>>& _functions
                                         ) const {
-
-    auto values = Operators::CONSTANTS;
+    // names that were never interned cannot occur in any expression
+    TExpressionBindings bindings;
     for (const auto &item : _values) {
-        values[item.first] = item.second;
+        const TSymbol symbol = TSymbolTable::global().find(item.first);
+        if (symbol != TSymbolTable::NONE)
+            bindings.set(symbol, item.second);
     }
-
-    if (!require_keys(values, variables))
-        throw std::invalid_argument("Not all variables values are present");
-
-    auto funcs = Operators::STD_FUNCTIONS;
     for (const auto &item : _functions) {
-        funcs[item.first] = item.second;
+        const TSymbol symbol = TSymbolTable::global().find(item.first);
+        if (symbol != TSymbolTable::NONE)
+            bindings.set_function(symbol, item.second);
     }
 
-    if (!require_keys(funcs, func_names))
+    return calculate(bindings);
+}
+
+template<class Probe>
+static double evaluate(const TDynamicList<TPostfixToken>& tokens, size_t stack_depth,
+                       const TExpressionBindings& bindings, Probe& probe);
+
+double TArithmeticExpression::calculate(const TExpressionBindings& bindings) const
+{
+    if (!std::all_of(variables.begin(), variables.end(), [&bindings](TSymbol s) { return bindings.has_value(s); }))
+        throw std::invalid_argument("Not all variables values are present");
+
+    if (!std::all_of(func_names.begin(), func_names.end(), [&bindings](TSymbol s) { return bindings.has_function(s); }))
         throw std::invalid_argument("Not all function implementations are present");
 
-    TStack<double> stack((tokens.size() / 2) + 1);
-    for (const auto& lexeme : tokens)
+    if (stack_depth == 0)
+        throw std::logic_error("Expression is empty");
+
+#ifdef POSTFIX_PROFILE_EVAL
+    TProfileProbe probe(infix, tokens.begin(), tokens.end());
+#else
+    TNoProbe probe;
+#endif
+    return evaluate(tokens, stack_depth, bindings, probe);
+}
+
+template<class Probe>
+static double evaluate(const TDynamicList<TPostfixToken>& tokens, size_t stack_depth,
+                       const TExpressionBindings& bindings, Probe& probe)
+{
+    // the program was verified when it was compiled or loaded
+    TUncheckedStack<double> stack(stack_depth);
+    for (size_t i = 0; i < tokens.size(); i++)
     {
-        switch (lexeme.type)
+        const TPostfixToken& token = tokens[i];
+        probe.before(i);
+        switch (token.kind)
         {
-            case TLexeme::Type::Operator: {
-                stack.push(Operators::LIST.at(lexeme.value.as_char()).handler(stack.pop_element(), stack.pop_element()));
+            case TPostfixToken::Kind::Operator: {
+                const double rhs = stack.pop_element();
+                double& lhs = stack.top();
+                lhs = Operators::apply(Operators::get(token.op).kernel, lhs, rhs);
+                break;
+            }
+            case TPostfixToken::Kind::Function: {
+                double& argument = stack.top();
+                argument = bindings.function(token.symbol).execute(argument);
                 break;
             }
-            case TLexeme::Type::Function: {
-                stack.push(funcs.at(lexeme.value.as_string())->execute(stack.pop_element()));
+            case TPostfixToken::Kind::Variable: {
+                stack.push(bindings.value(token.symbol));
                 break;
             }
-            case TLexeme::Type::Variable:
-            case TLexeme::Type::Number: {
-                stack.push(lexeme.type == TLexeme::Type::Number
-                        ? lexeme.value.as_number()
-                        : values.at(lexeme.value.as_string()));
+            case TPostfixToken::Kind::Number: {
+                stack.push(token.number);
                 break;
             }
             default: {
                 throw std::runtime_error("Unimplemented");
             }
         }
+        probe.after(i);
     }
 
+    assert(stack.size() == 1);
     return stack.top();
-}
\ No newline at end of file
+}
+
+template<TArithmeticOperator::Kernel kernel>
+static void apply_rows(double* lhs, const double* rhs, size_t rows)
+{
+    // the kernel is a constant here, so simple operators compile to vector code
+    for (size_t r = 0; r < rows; r++)
+    {
+        lhs[r] = Operators::apply(kernel, lhs[r], rhs[r]);
+    }
+}
+
+static void apply_rows(TArithmeticOperator::Kernel kernel, double* lhs, const double* rhs, size_t rows)
+{
+    using Kernel = TArithmeticOperator::Kernel;
+    switch (kernel)
+    {
+        case Kernel::Add: return apply_rows<Kernel::Add>(lhs, rhs, rows);
+        case Kernel::Subtract: return apply_rows<Kernel::Subtract>(lhs, rhs, rows);
+        case Kernel::Multiply: return apply_rows<Kernel::Multiply>(lhs, rhs, rows);
+        case Kernel::Divide: return apply_rows<Kernel::Divide>(lhs, rhs, rows);
+        case Kernel::Modulo: return apply_rows<Kernel::Modulo>(lhs, rhs, rows);
+        case Kernel::Power: return apply_rows<Kernel::Power>(lhs, rhs, rows);
+        case Kernel::Negate: return apply_rows<Kernel::Negate>(lhs, rhs, rows);
+        case Kernel::Factorial: return apply_rows<Kernel::Factorial>(lhs, rhs, rows);
+        default: throw std::runtime_error("Unimplemented");
+    }
+}
+
+void TArithmeticExpression::calculate_batch(const TExpressionBindings& bindings, const TExpressionColumns& columns,
+                                            size_t rows, double* results) const
+{
+    if (!std::all_of(variables.begin(), variables.end(),
+                     [&](TSymbol s) { return columns.has_column(s) || bindings.has_value(s); }))
+        throw std::invalid_argument("Not all variables values are present");
+
+    if (!std::all_of(func_names.begin(), func_names.end(), [&bindings](TSymbol s) { return bindings.has_function(s); }))
+        throw std::invalid_argument("Not all function implementations are present");
+
+    if (stack_depth == 0)
+        throw std::logic_error("Expression is empty");
+
+    // every stack slot holds the values of a whole block of rows
+    const size_t BLOCK = 256;
+    const std::unique_ptr<double[]> stack(new double[stack_depth * BLOCK]);
+    const auto slot = [&stack](size_t depth) { return stack.get() + depth * BLOCK; };
+
+    for (size_t first = 0; first < rows; first += BLOCK)
+    {
+        const size_t count = std::min(BLOCK, rows - first);
+        size_t depth = 0;
+        for (const auto& token : tokens)
+        {
+            switch (token.kind)
+            {
+                case TPostfixToken::Kind::Operator: {
+                    depth--;
+                    apply_rows(Operators::get(token.op).kernel, slot(depth - 1), slot(depth), count);
+                    break;
+                }
+                case TPostfixToken::Kind::Function: {
+                    TArithmeticExpressionFunction& function = bindings.function(token.symbol);
+                    double* arguments = slot(depth - 1);
+                    for (size_t r = 0; r < count; r++)
+                    {
+                        arguments[r] = function.execute(arguments[r]);
+                    }
+                    break;
+                }
+                case TPostfixToken::Kind::Variable: {
+                    if (columns.has_column(token.symbol))
+                    {
+                        const auto& column = columns.column(token.symbol);
+                        const double* values = column.values + first * column.stride;
+                        double* target = slot(depth++);
+                        if (column.stride == 1)
+                        {
+                            std::copy(values, values + count, target);
+                        }
+                        else
+                        {
+                            for (size_t r = 0; r < count; r++)
+                            {
+                                target[r] = values[r * column.stride];
+                            }
+                        }
+                    }
+                    else
+                    {
+                        std::fill_n(slot(depth++), count, bindings.value(token.symbol));
+                    }
+                    break;
+                }
+                case TPostfixToken::Kind::Number: {
+                    std::fill_n(slot(depth++), count, token.number);
+                    break;
+                }
+                default: {
+                    throw std::runtime_error("Unimplemented");
+                }
+            }
+        }
+
+        assert(depth == 1);
+        std::copy(slot(0), slot(0) + count, results + first);
+    }
+}
+
+bool TArithmeticExpression::verify_program()
+{
+    size_t depth = 0;
+    size_t max_depth = 0;
+    for (const auto& token : tokens)
+    {
+        switch (token.kind)
+        {
+            case TPostfixToken::Kind::Number:
+            case TPostfixToken::Kind::Variable:
+                max_depth = std::max(max_depth, ++depth);
+                break;
+            case TPostfixToken::Kind::Function:
+                if (depth < 1)
+                    return false;
+                break;
+            case TPostfixToken::Kind::Operator:
+                if (depth < 2)
+                    return false;
+                depth--;
+                break;
+            default:
+                return false;
+        }
+    }
+
+    if (!tokens.empty() && depth != 1)
+        return false;
+
+    stack_depth = max_depth;
+    return true;
+}
@@ -0,0 +1,154 @@
+#include "registry.h"
+#include "bulk.h"
+#include "image.h"
+#include "mapped_file.h"
+#include <cctype>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+struct TLine {
+    size_t number;
+    std::string_view name;
+    std::string_view infix;
+    size_t infix_column;
+};
+
+std::string_view trim(std::string_view s)
+{
+    while (!s.empty() && isspace((unsigned char)s.front()))
+        s.remove_prefix(1);
+    while (!s.empty() && isspace((unsigned char)s.back()))
+        s.remove_suffix(1);
+    return s;
+}
+
+// splits the text into views of non-blank lines without copying anything
+std::vector<TLine> split_lines(std::string_view text)
+{
+    std::vector<TLine> lines;
+
+    size_t number = 0;
+    while (!text.empty())
+    {
+        number++;
+
+        const char* eol = static_cast<const char*>(memchr(text.data(), '\n', text.size()));
+        const size_t length = eol ? (size_t)(eol - text.data()) : text.size();
+        const std::string_view line = text.substr(0, length);
+        text.remove_prefix(eol ? length + 1 : length);
+
+        if (trim(line).empty())
+            continue;
+
+        TLine parsed = { number, {}, line, 1 };
+        const size_t eq = line.find('=');
+        if (eq != std::string_view::npos)
+        {
+            parsed.name = trim(line.substr(0, eq));
+            parsed.infix = line.substr(eq + 1);
+            parsed.infix_column = eq + 2;
+        }
+        // drop the carriage return of CRLF files
+        if (!parsed.infix.empty() && parsed.infix.back() == '\r')
+            parsed.infix.remove_suffix(1);
+
+        lines.push_back(parsed);
+    }
+
+    return lines;
+}
+
+}
+
+TFormulaRegistry TFormulaRegistry::load(const std::string& path, TThreadPool& pool)
+{
+    const TMappedFile file(path);
+    return parse(file.view(), pool);
+}
+
+TFormulaRegistry TFormulaRegistry::parse(std::string_view text, TThreadPool& pool)
+{
+    const std::vector<TLine> lines = split_lines(text);
+
+    std::vector<std::string_view> infixes;
+    infixes.reserve(lines.size());
+    for (const TLine& line : lines)
+    {
+        infixes.push_back(line.infix);
+    }
+    std::vector<TCompilationResult> compiled = compile_bulk(infixes, pool);
+
+    TFormulaRegistry registry;
+    registry.entries.reserve(lines.size());
+    for (size_t i = 0; i < lines.size(); i++)
+    {
+        const TLine& line = lines[i];
+        TCompilationResult& result = compiled[i];
+
+        if (trim(line.infix).empty())
+        {
+            registry.errors.push_back({ line.number, line.infix_column, "Missing formula after =",
+                                        expression_validation_error::cause::Generic });
+            continue;
+        }
+        if (!result.ok())
+        {
+            const size_t column = result.error.pos > 0 ? line.infix_column + result.error.pos - 1 : line.infix_column;
+            registry.errors.push_back({ line.number, column, result.error.message, result.error.cause });
+            continue;
+        }
+
+        std::string name(line.name);
+        if (!name.empty())
+        {
+            if (registry.index.find(name) != registry.index.end())
+            {
+                registry.errors.push_back({ line.number, 1, "Duplicate formula name: " + name,
+                                            expression_validation_error::cause::Generic });
+                continue;
+            }
+            registry.index.emplace(name, registry.entries.size());
+        }
+        registry.entries.push_back({ std::move(name), line.number, std::move(result.expression) });
+    }
+
+    return registry;
+}
+
+std::shared_ptr<const TArithmeticExpression> TFormulaRegistry::find(const std::string& name) const
+{
+    const auto it = index.find(name);
+    return it != index.end() ? entries[it->second].expression : nullptr;
+}
+
+void TFormulaRegistry::save_image(const std::string& path) const
+{
+    std::vector<TExpressionImage::TEntry> image_entries;
+    image_entries.reserve(entries.size());
+    for (const auto& entry : entries)
+    {
+        image_entries.push_back({ entry.name, entry.expression });
+    }
+
+    const std::string image = TExpressionImage::encode(image_entries);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.write(image.data(), (std::streamsize)image.size()))
+        throw std::runtime_error("Cannot write file: " + path);
+}
+
+TFormulaRegistry TFormulaRegistry::load_image(const std::string& path)
+{
+    const TMappedFile file(path);
+
+    TFormulaRegistry registry;
+    for (auto& entry : TExpressionImage::decode(file.view()))
+    {
+        if (!entry.name.empty())
+            registry.index.emplace(entry.name, registry.entries.size());
+        registry.entries.push_back({ std::move(entry.name), 0, std::move(entry.expression) });
+    }
+    return registry;
+}
@@ -0,0 +1,53 @@
+#include "symbols.h"
+#include <mutex>
+#include <stdexcept>
+
+TSymbol TSymbolTable::intern(std::string_view name)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        const auto it = index.find(name);
+        if (it != index.end())
+            return it->second;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    const auto it = index.find(name);
+    if (it != index.end())
+        return it->second;
+
+    if (names.size() >= NONE)
+        throw std::length_error("Symbol table is full");
+
+    const auto symbol = (TSymbol)names.size();
+    names.emplace_back(name);
+    index.emplace(names.back(), symbol);
+    return symbol;
+}
+
+TSymbol TSymbolTable::find(std::string_view name) const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    const auto it = index.find(name);
+    return it != index.end() ? it->second : NONE;
+}
+
+const std::string& TSymbolTable::name(TSymbol symbol) const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (symbol >= names.size())
+        throw std::out_of_range("Unknown symbol");
+    return names[symbol];
+}
+
+size_t TSymbolTable::size() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return names.size();
+}
+
+TSymbolTable& TSymbolTable::global()
+{
+    static TSymbolTable table;
+    return table;
+}
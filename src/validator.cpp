@@ -1,137 +1,235 @@
 #include "validator.h"
 #include "operators.h"
-#include "stack.h"
 #include <stdexcept>
+#include <array>
 #include <cassert>
 
-enum class ExpressionSymbol {
-    Begin,
+static constexpr std::array<ExpressionSymbol, 256> make_symbol_table()
+{
+    std::array<ExpressionSymbol, 256> table {};
+    for (int c = 0; c < 256; c++)
+    {
+        if (c == ' ' || (c >= '\t' && c <= '\r'))
+            table[c] = ExpressionSymbol::Space;
+        else if (c == '(')
+            table[c] = ExpressionSymbol::OpeningBracket;
+        else if (c == ')')
+            table[c] = ExpressionSymbol::ClosingBracket;
+        else if (c == '-')
+            table[c] = ExpressionSymbol::Minus;
+        else if (Operators::is_operator((char)c))
+            table[c] = Operators::get((char)c).type == TArithmeticOperator::Type::UnaryPostfix
+                    ? ExpressionSymbol::PostfixOperator
+                    : ExpressionSymbol::Operator;
+        else if (c == '.')
+            table[c] = ExpressionSymbol::Dot;
+        else if (c >= '0' && c <= '9')
+            table[c] = ExpressionSymbol::Digit;
+        else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+            table[c] = ExpressionSymbol::Letter;
+        else
+            table[c] = ExpressionSymbol::Unknown;
+    }
+    return table;
+}
 
-    Space,
+// classification of every byte, as the C locale sees it
+static constexpr std::array<ExpressionSymbol, 256> SYMBOLS = make_symbol_table();
 
-    Digit,
-    Dot,
-    Letter,
+ExpressionSymbol get_type(const char c)
+{
+    return SYMBOLS[(unsigned char)c];
+}
 
-    OpeningBracket,
-    ClosingBracket,
+namespace {
+
+enum class ValidationError : uint8_t {
+    None,
+    UnexpectedOperator,
+    MalformedNumber,
+    MissingFraction,
+    MalformedOperator,
+    UselessOperator,
+    MissingOperator,
+    EmptyCall,
+    MissingOperand
+};
 
-    Operator,
+struct TValidationErrorInfo {
+    const char* message;
+    expression_validation_error::cause cause;
+};
 
-    Unknown
+const TValidationErrorInfo ERRORS[] = {
+    { "", expression_validation_error::cause::Generic },
+    { "Unexpected operator", expression_validation_error::cause::BadOperator },
+    { "Malformed number", expression_validation_error::cause::BadNumber },
+    { "Malformed number, fractional part expected", expression_validation_error::cause::BadNumber },
+    { "Malformed operator", expression_validation_error::cause::BadOperator },
+    { "Useless operator at the end of the expression", expression_validation_error::cause::BadOperator },
+    { "Missing operator between operands", expression_validation_error::cause::MissingOperator },
+    { "Function call without an argument", expression_validation_error::cause::EmptyCall },
+    { "Empty brackets in place of an operand", expression_validation_error::cause::MissingOperand },
 };
 
-ExpressionSymbol get_type(const char c)
+struct TTransition {
+    ExpressionSymbol next;
+    ValidationError error;
+};
+
+constexpr size_t SYMBOL_COUNT = (size_t)ExpressionSymbol::Count;
+using TTransitionTable = std::array<std::array<TTransition, SYMBOL_COUNT>, SYMBOL_COUNT>;
+
+constexpr bool is_operator_symbol(ExpressionSymbol s)
 {
-    if (isspace(c))
-    {
-        return ExpressionSymbol::Space;
-    }
-    else if (c == '(')
-    {
-        return ExpressionSymbol::OpeningBracket;
-    }
-    else if (c == ')')
-    {
-        return ExpressionSymbol::ClosingBracket;
-    }
-    else if (Operators::is_operator(c))
-    {
-        return ExpressionSymbol::Operator;
-    }
-    else if (c == '.')
-    {
-        return ExpressionSymbol::Dot;
-    }
-    else if (isdigit(c))
-    {
-        return ExpressionSymbol::Digit;
-    }
-    else if (isalpha(c))
-    {
-        return ExpressionSymbol::Letter;
-    }
-    return ExpressionSymbol::Unknown;
+    return s == ExpressionSymbol::Operator || s == ExpressionSymbol::Minus || s == ExpressionSymbol::PostfixOperator;
 }
 
-std::string& validate_infix(const std::string& infix)
+constexpr bool starts_operand(ExpressionSymbol s)
 {
-    ExpressionSymbol previous = ExpressionSymbol::Begin;
-
-    TStack<size_t> brackets;
+    return s == ExpressionSymbol::Digit || s == ExpressionSymbol::Dot || s == ExpressionSymbol::Letter
+        || s == ExpressionSymbol::OpeningBracket;
+}
 
-    size_t i = 0;
-    for (const char c : infix)
+constexpr TTransitionTable make_transition_table()
+{
+    TTransitionTable table {};
+    for (size_t from = 0; from < SYMBOL_COUNT; from++)
     {
-        ++i;
+        for (size_t to = 0; to < SYMBOL_COUNT; to++)
+        {
+            const auto state = (ExpressionSymbol)from;
+            const auto current = (ExpressionSymbol)to;
 
-        const ExpressionSymbol current = get_type(c);
-        assert(current != ExpressionSymbol::Unknown);
+            // a minus leaves the validator in the same state as any infix operator
+            table[from][to] = { current == ExpressionSymbol::Minus ? ExpressionSymbol::Operator : current,
+                                ValidationError::None };
 
-        if (current == ExpressionSymbol::OpeningBracket)
-        {
-            brackets.push(i);
-        }
-        else if (current == ExpressionSymbol::ClosingBracket)
-        {
-            if (brackets.empty())
+            switch (state)
             {
-                throw expression_validation_error("Missing opening bracket", i,
-                                                  expression_validation_error::cause::MissingBracket);
+                case ExpressionSymbol::Begin:
+                case ExpressionSymbol::OpeningBracket:
+                    if (current == ExpressionSymbol::Operator || current == ExpressionSymbol::PostfixOperator)
+                        table[from][to].error = ValidationError::UnexpectedOperator;
+                    break;
+                case ExpressionSymbol::Digit:
+                    if (current != ExpressionSymbol::Digit && current != ExpressionSymbol::Dot
+                        && !is_operator_symbol(current) && current != ExpressionSymbol::Space
+                        && current != ExpressionSymbol::ClosingBracket)
+                        table[from][to].error = ValidationError::MalformedNumber;
+                    break;
+                case ExpressionSymbol::Dot:
+                    if (current != ExpressionSymbol::Digit)
+                        table[from][to].error = ValidationError::MissingFraction;
+                    break;
+                case ExpressionSymbol::Letter:
+                    if (current == ExpressionSymbol::OpeningBracket)
+                        table[from][to].next = ExpressionSymbol::Call;
+                    break;
+                case ExpressionSymbol::Call:
+                    if (current == ExpressionSymbol::ClosingBracket)
+                        table[from][to].error = ValidationError::EmptyCall;
+                    else if (current == ExpressionSymbol::Operator || current == ExpressionSymbol::PostfixOperator)
+                        table[from][to].error = ValidationError::UnexpectedOperator;
+                    break;
+                case ExpressionSymbol::ClosingBracket:
+                case ExpressionSymbol::PostfixOperator:
+                    if (starts_operand(current))
+                        table[from][to].error = ValidationError::MissingOperator;
+                    break;
+                case ExpressionSymbol::Operator:
+                    if (current == ExpressionSymbol::ClosingBracket || is_operator_symbol(current))
+                        table[from][to].error = ValidationError::MalformedOperator;
+                    break;
+                default:
+                    break;
             }
-            brackets.pop();
         }
+    }
+    return table;
+}
 
-        switch (previous) {
-            case ExpressionSymbol::Begin: {
-                if (current == ExpressionSymbol::Operator && c != '-')
-                {
-                    throw expression_validation_error("Unexpected operator", i,
-                                                      expression_validation_error::cause::BadOperator);
-                }
-                break;
-            }
-            case ExpressionSymbol::Digit: {
-                if (current != ExpressionSymbol::Digit && current != ExpressionSymbol::Dot
-                    && current != ExpressionSymbol::Operator && current != ExpressionSymbol::Space && c != ')')
-                {
-                    throw expression_validation_error("Malformed number", i,
-                                                      expression_validation_error::cause::BadNumber);
-                }
-                break;
-            }
-            case ExpressionSymbol::Dot: {
-                if (current != ExpressionSymbol::Digit)
-                {
-                    throw expression_validation_error("Malformed number, fractional part expected", i,
-                                                      expression_validation_error::cause::BadNumber);
-                }
-                break;
-            }
-            case ExpressionSymbol::Operator: {
-                if ((i > 1 && infix[i - 2] != '!') && (current == ExpressionSymbol::ClosingBracket || current == ExpressionSymbol::Operator))
-                {
-                    throw expression_validation_error("Malformed operator", i,
-                                                      expression_validation_error::cause::BadOperator);
-                }
-                break;
-            }
-        }
+constexpr TTransitionTable TRANSITIONS = make_transition_table();
+
+[[noreturn]] void fail(ValidationError error, size_t pos)
+{
+    const TValidationErrorInfo& info = ERRORS[(size_t)error];
+    throw expression_validation_error(info.message, pos, info.cause);
+}
+
+}
 
-        previous = current;
+void TInfixValidator::feed(const ExpressionSymbol current)
+{
+    const size_t i = ++pos;
+
+    assert(current != ExpressionSymbol::Unknown);
+
+    // spaces keep the state, but a dot still needs its fraction right after it
+    if (current == ExpressionSymbol::Space)
+    {
+        const ValidationError error = TRANSITIONS[(size_t)state][(size_t)current].error;
+        if (error != ValidationError::None)
+            fail(error, i);
+        return;
     }
 
-    if (previous == ExpressionSymbol::Operator && infix[i - 1] != '!')
+    if (current == ExpressionSymbol::OpeningBracket)
     {
-        throw expression_validation_error("Useless operator at the end of the expression", i,
-                                          expression_validation_error::cause::BadOperator);
+        brackets.push(i);
     }
+    else if (current == ExpressionSymbol::ClosingBracket)
+    {
+        if (brackets.empty())
+        {
+            throw expression_validation_error("Missing opening bracket", i,
+                                              expression_validation_error::cause::MissingBracket);
+        }
+        brackets.pop();
+    }
+
+    const TTransition& transition = TRANSITIONS[(size_t)state][(size_t)current];
+    if (transition.error != ValidationError::None)
+        fail(transition.error, i);
+
+    // empty brackets only make up an empty expression, never an operand
+    const bool bracket = current == ExpressionSymbol::OpeningBracket || current == ExpressionSymbol::ClosingBracket;
+    if (state == ExpressionSymbol::OpeningBracket && current == ExpressionSymbol::ClosingBracket)
+    {
+        if (!only_brackets)
+            fail(ValidationError::MissingOperand, i);
+        empty_group = true;
+    }
+    else if (empty_group && current != ExpressionSymbol::ClosingBracket)
+    {
+        fail(ValidationError::MissingOperand, i);
+    }
+    only_brackets = only_brackets && bracket;
+
+    state = transition.next;
+}
+
+void TInfixValidator::finish()
+{
+    if (state == ExpressionSymbol::Operator)
+        fail(ValidationError::UselessOperator, pos);
 
     if (!brackets.empty())
     {
         throw expression_validation_error("Missing closing bracket", brackets.top(),
                                           expression_validation_error::cause::MissingBracket);
     }
+}
+
+std::string& validate_infix(const std::string& infix)
+{
+    TInfixValidator validator;
+
+    for (const char c : infix)
+    {
+        validator.feed(get_type(c));
+    }
+    validator.finish();
 
     return const_cast<std::string &>(infix);
-}
\ No newline at end of file
+}
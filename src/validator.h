@@ -1,7 +1,63 @@
 #ifndef __VALIDATOR_H__
 #define __VALIDATOR_H__
 
+#include <cstdint>
 #include <string>
+#include "stack.h"
+
+// Character classes of the infix, doubling as the states of the validator:
+// the state is the class of the previous significant symbol. Spaces do not
+// change the state
+enum class ExpressionSymbol : uint8_t {
+    Begin,
+
+    Space,
+
+    Digit,
+    Dot,
+    Letter,
+
+    OpeningBracket,
+    // state only: an opening bracket right after a name
+    Call,
+    ClosingBracket,
+
+    Operator,
+    // the only operator allowed at the beginning
+    Minus,
+    // the only operator allowed to be followed by another one
+    PostfixOperator,
+
+    Unknown,
+
+    Count
+};
+
+ExpressionSymbol get_type(char c);
+
+// Incremental validator: consumes the infix one symbol at a time so that
+// the compiler can validate in the same scan it lexes in.
+// Driven by a constexpr transition table over ExpressionSymbol
+class TInfixValidator {
+private:
+    ExpressionSymbol state = ExpressionSymbol::Begin;
+    size_t pos = 0;
+
+    // whether the input so far is nothing but brackets, and holds a "()"
+    bool only_brackets = true;
+    bool empty_group = false;
+
+    TStack<size_t, 32> brackets;
+public:
+    void feed(ExpressionSymbol current);
+    void finish();
+
+    [[nodiscard]]
+    size_t position() const noexcept
+    {
+        return pos;
+    }
+};
 
 std::string& validate_infix(const std::string& infix);
 
@@ -0,0 +1,155 @@
+#include "allocations.h"
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    thread_local TAllocationCounts thread_counts;
+}
+
+TAllocationScope::TAllocationScope()
+    : start(thread_counts)
+{}
+
+TAllocationCounts TAllocationScope::counts() const
+{
+    const TAllocationCounts now = thread_counts;
+    return { now.allocations - start.allocations,
+             now.deallocations - start.deallocations,
+             now.bytes - start.bytes };
+}
+
+// Every form is replaced, so that no allocation or deallocation goes to an
+// implementation the counters do not see (sanitizers provide their own)
+namespace
+{
+    void* counted_allocate(size_t size)
+    {
+        thread_counts.allocations++;
+        thread_counts.bytes += size;
+        return std::malloc(size > 0 ? size : 1);
+    }
+
+    void* counted_allocate(size_t size, std::align_val_t alignment)
+    {
+        thread_counts.allocations++;
+        thread_counts.bytes += size;
+        const size_t align = (size_t)alignment;
+        // aligned_alloc wants the size to be a multiple of the alignment
+        return std::aligned_alloc(align, (size + align) / align * align);
+    }
+
+    void counted_free(void* p) noexcept
+    {
+        if (p != nullptr)
+            thread_counts.deallocations++;
+        std::free(p);
+    }
+
+    void* or_throw(void* p)
+    {
+        if (p == nullptr)
+            throw std::bad_alloc();
+        return p;
+    }
+}
+
+void* operator new(size_t size)
+{
+    return or_throw(counted_allocate(size));
+}
+
+void* operator new[](size_t size)
+{
+    return or_throw(counted_allocate(size));
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return counted_allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return counted_allocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    return or_throw(counted_allocate(size, alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    return or_throw(counted_allocate(size, alignment));
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return counted_allocate(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return counted_allocate(size, alignment);
+}
+
+void operator delete(void* p) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete[](void* p, size_t, std::align_val_t) noexcept
+{
+    counted_free(p);
+}
@@ -0,0 +1,29 @@
+#ifndef __ALLOCATIONS_H__
+#define __ALLOCATIONS_H__
+
+#include <cstddef>
+#include <cstdint>
+
+// Heap activity seen through the global operator new/delete
+struct TAllocationCounts {
+    uint64_t allocations = 0;
+    uint64_t deallocations = 0;
+    uint64_t bytes = 0;
+};
+
+// Counts the allocations made by the calling thread while the scope is
+// alive. The test binary replaces the global operator new/delete to do so
+class TAllocationScope {
+private:
+    const TAllocationCounts start;
+public:
+    TAllocationScope();
+    TAllocationScope(const TAllocationScope&) = delete;
+    TAllocationScope& operator=(const TAllocationScope&) = delete;
+
+    // since the scope was opened
+    [[nodiscard]]
+    TAllocationCounts counts() const;
+};
+
+#endif // __ALLOCATIONS_H__
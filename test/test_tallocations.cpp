@@ -0,0 +1,121 @@
+#include <gtest.h>
+#include "allocations.h"
+#include "eval_profile.h"
+#include "postfix.h"
+
+namespace
+{
+    struct TBudget {
+        const char* infix;
+        uint64_t allocations;
+    };
+
+    // current profile of the compiler, symbols already interned. A change
+    // that exceeds one of these should say why in its description
+    const TBudget construction_budgets[] = {
+        { "2 + 3", 1 },
+        { "(a + b) * sin(c) - 2", 6 },
+        { "-x^2 + 3!*y", 4 },
+        { "price * qty * (1 + rate) - sqrt(price * base) + delta", 9 },
+        // names past the short string capacity are copied on their way through the compiler
+        { "aRatherLongVariableName * (b + c) - sin(aRatherLongVariableName) / 2", 14 },
+    };
+
+    TExpressionBindings bind_all(const TArithmeticExpression& expr)
+    {
+        TExpressionBindings bindings;
+        for (const auto& name : expr.get_variables())
+        {
+            bindings.set(name, 2);
+        }
+        return bindings;
+    }
+}
+
+TEST(TAllocationScope, counts_calling_thread)
+{
+    TAllocationScope scope;
+    auto value = std::make_unique<double>(1);
+    EXPECT_EQ(1, scope.counts().allocations);
+    EXPECT_EQ(sizeof(double), scope.counts().bytes);
+    EXPECT_EQ(0, scope.counts().deallocations);
+
+    value.reset();
+    EXPECT_EQ(1, scope.counts().deallocations);
+}
+
+TEST(TAllocationScope, construction_within_budget)
+{
+    for (const auto& budget : construction_budgets)
+    {
+        // interns the names, later compilations only look them up
+        TArithmeticExpression warm_up(budget.infix);
+
+        TAllocationScope scope;
+        TArithmeticExpression expr(budget.infix);
+        EXPECT_LE(scope.counts().allocations, budget.allocations) << budget.infix;
+    }
+}
+
+TEST(TAllocationScope, failed_construction_releases_everything)
+{
+    TAllocationScope scope;
+    EXPECT_ANY_THROW(TArithmeticExpression expr("aRatherLongVariableName * (b + c"));
+    // the exception object itself is not allocated through operator new
+    EXPECT_EQ(scope.counts().allocations, scope.counts().deallocations);
+}
+
+TEST(TAllocationScope, calculate_does_not_allocate)
+{
+    if (TEvaluationProfile::enabled())
+        return;
+
+    for (const auto& budget : construction_budgets)
+    {
+        const TArithmeticExpression expr(budget.infix);
+        const TExpressionBindings bindings = bind_all(expr);
+        const double expected = expr.calculate(bindings);
+
+        TAllocationScope scope;
+        for (int i = 0; i < 100; i++)
+        {
+            EXPECT_EQ(expected, expr.calculate(bindings)) << budget.infix;
+        }
+        EXPECT_EQ(0, scope.counts().allocations) << budget.infix;
+    }
+}
+
+TEST(TAllocationScope, deep_calculate_allocates_its_stack_once)
+{
+    if (TEvaluationProfile::enabled())
+        return;
+
+    // a+(a+(a+...)) keeps every operand on the stack
+    std::string infix;
+    for (int i = 0; i < 100; i++)
+    {
+        infix += "a+(";
+    }
+    infix += "a";
+    infix.append(100, ')');
+
+    const TArithmeticExpression expr(infix);
+    const TExpressionBindings bindings = bind_all(expr);
+
+    TAllocationScope scope;
+    EXPECT_EQ(202, expr.calculate(bindings));
+    EXPECT_EQ(1, scope.counts().allocations);
+    EXPECT_EQ(1, scope.counts().deallocations);
+}
+
+TEST(TAllocationScope, postfix_text_is_built_once)
+{
+    const TArithmeticExpression expr("(a + b) * sin(c) - 2");
+    const auto first = expr.get_postfix_text();
+
+    TAllocationScope scope;
+    EXPECT_EQ(first, expr.get_postfix_text());
+    EXPECT_EQ(8, expr.get_postfix().size());
+    EXPECT_EQ(3, expr.get_variables().size());
+    EXPECT_EQ(0, scope.counts().allocations);
+}
@@ -0,0 +1,88 @@
+#include <gtest.h>
+#include "bulk.h"
+
+TEST(TBulkCompilation, try_compile_reports_errors_as_values)
+{
+    const auto ok = try_compile("1+2");
+    ASSERT_TRUE(ok.ok());
+    EXPECT_EQ(3, ok.expression->calculate());
+
+    const auto bad = try_compile("(1+2");
+    ASSERT_FALSE(bad.ok());
+    EXPECT_EQ(expression_validation_error::cause::MissingBracket, bad.error.cause);
+    EXPECT_EQ(1, bad.error.pos);
+}
+
+TEST(TBulkCompilation, keeps_input_order)
+{
+    TThreadPool pool(4);
+
+    std::vector<std::string> infixes;
+    for (int i = 0; i < 1000; i++)
+    {
+        infixes.push_back(i % 10 == 0 ? "1++" + std::to_string(i) : std::to_string(i) + "*x");
+    }
+
+    const auto results = compile_bulk(infixes, pool);
+
+    ASSERT_EQ(infixes.size(), results.size());
+    for (int i = 0; i < 1000; i++)
+    {
+        if (i % 10 == 0)
+        {
+            EXPECT_FALSE(results[i].ok());
+            EXPECT_EQ(expression_validation_error::cause::BadOperator, results[i].error.cause);
+        }
+        else
+        {
+            ASSERT_TRUE(results[i].ok());
+            EXPECT_EQ(i * 2, results[i].expression->calculate({ { "x", 2 } }));
+        }
+    }
+}
+
+TEST(TThreadPool, covers_whole_range_once)
+{
+    TThreadPool pool(3);
+    std::vector<std::atomic<int>> hits(10000);
+
+    pool.parallel_for(hits.size(), 7, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            hits[i]++;
+    });
+
+    for (const auto& hit : hits)
+        EXPECT_EQ(1, hit.load());
+}
+
+TEST(TThreadPool, rethrows_exceptions_in_caller)
+{
+    TThreadPool pool(2);
+
+    EXPECT_THROW(pool.parallel_for(100, 1, [](size_t begin, size_t) {
+        if (begin == 42)
+            throw std::runtime_error("failure");
+    }), std::runtime_error);
+}
+
+TEST(TThreadPool, runs_nested_calls_inline)
+{
+    TThreadPool pool(3);
+    std::vector<std::atomic<int>> hits(100 * 100);
+
+    // the caller takes chunks of the outer call as well as the workers
+    pool.parallel_for(100, 1, [&](size_t outer, size_t) {
+        pool.parallel_for(100, 10, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+                hits[outer * 100 + i]++;
+        });
+    });
+
+    for (const auto& hit : hits)
+        EXPECT_EQ(1, hit.load());
+
+    // and the pool takes new work afterwards
+    std::atomic<int> total { 0 };
+    pool.parallel_for(100, 1, [&](size_t, size_t) { total++; });
+    EXPECT_EQ(100, total.load());
+}
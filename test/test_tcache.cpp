@@ -0,0 +1,85 @@
+#include <gtest.h>
+#include "cache.h"
+#include <thread>
+
+TEST(TArithmeticExpressionCache, returns_same_instance_on_hit)
+{
+    TArithmeticExpressionCache cache(8, 1);
+
+    const auto first = cache.get("a+b");
+    const auto second = cache.get("a+b");
+
+    EXPECT_EQ(first.get(), second.get());
+    EXPECT_EQ(1, cache.statistics().hits);
+    EXPECT_EQ(1, cache.statistics().misses);
+}
+
+TEST(TArithmeticExpressionCache, ignores_whitespace_differences)
+{
+    TArithmeticExpressionCache cache(8, 1);
+
+    const auto first = cache.get("a + b * 2");
+    const auto second = cache.get(" a+b*2 ");
+
+    EXPECT_EQ(first.get(), second.get());
+    EXPECT_EQ(1, cache.size());
+
+    // bytes beyond ASCII are not whitespace
+    EXPECT_EQ("a\xa0+b", TArithmeticExpressionCache::normalize("a\xa0 + b"));
+}
+
+TEST(TArithmeticExpressionCache, keeps_spaces_after_a_dot)
+{
+    TArithmeticExpressionCache cache(8, 1);
+
+    cache.get("1.5 + 1");
+    EXPECT_THROW(cache.get("1. 5 + 1"), expression_validation_error);
+    EXPECT_EQ(1, cache.size());
+}
+
+TEST(TArithmeticExpressionCache, evicts_least_recently_used)
+{
+    TArithmeticExpressionCache cache(2, 1);
+
+    const auto one = cache.get("1");
+    cache.get("2");
+    cache.get("1");
+    cache.get("3");
+
+    EXPECT_EQ(2, cache.size());
+    EXPECT_EQ(1, cache.statistics().evictions);
+    EXPECT_EQ(one.get(), cache.get("1").get());
+}
+
+TEST(TArithmeticExpressionCache, does_not_cache_invalid_expressions)
+{
+    TArithmeticExpressionCache cache(8, 1);
+
+    EXPECT_THROW(cache.get("1++1"), expression_validation_error);
+    EXPECT_EQ(0, cache.size());
+}
+
+TEST(TArithmeticExpressionCache, can_be_shared_between_threads)
+{
+    TArithmeticExpressionCache cache(64, 4);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&cache]() {
+            for (int i = 0; i < 1000; i++)
+            {
+                const auto expr = cache.get(std::to_string(i % 32) + "+x");
+                EXPECT_EQ(i % 32 + 1, expr->calculate({ { "x", 1 } }));
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    const auto stats = cache.statistics();
+    EXPECT_EQ(4000, stats.hits + stats.misses);
+    EXPECT_EQ(32, cache.size());
+}
@@ -0,0 +1,91 @@
+#include <gtest.h>
+#include "column_file.h"
+#include <cstdio>
+#include <fstream>
+
+namespace
+{
+    void write_raw(const std::string& path, const std::vector<double>& values)
+    {
+        std::ofstream out(path, std::ios::binary);
+        out.write((const char*)values.data(), (std::streamsize)(values.size() * sizeof(double)));
+    }
+
+    std::vector<double> read_raw(const std::string& path)
+    {
+        const TMappedFile file(path);
+        const double* values = (const double*)file.data();
+        return std::vector<double>(values, values + file.size() / sizeof(double));
+    }
+}
+
+TEST(TColumnFile, evaluates_interleaved_and_raw_columns)
+{
+    // more rows than a single pool task takes
+    const size_t rows = 200000;
+    std::vector<double> x(rows), y(rows), z(rows);
+    for (size_t r = 0; r < rows; r++)
+    {
+        x[r] = r * 0.25;
+        y[r] = (double)(r % 13) - 6;
+        z[r] = r % 5 + 1;
+    }
+
+    const std::string interleaved_path = "test_tcolumn_file_xy.pfxc";
+    const std::string raw_path = "test_tcolumn_file_z.bin";
+    const std::string output_path = "test_tcolumn_file_out.bin";
+    TColumnFile::write_interleaved(interleaved_path, { "x", "y" }, { x.data(), y.data() }, rows);
+    write_raw(raw_path, z);
+
+    std::vector<double> results;
+    {
+        const TColumnFile xy = TColumnFile::open_interleaved(interleaved_path);
+        const TColumnFile zc = TColumnFile::open_raw(raw_path, "z");
+        EXPECT_EQ(rows, xy.rows());
+        EXPECT_EQ(std::vector<std::string>({ "x", "y" }), xy.columns());
+        EXPECT_EQ(rows, zc.rows());
+
+        const TArithmeticExpression expr("x * y - z / 2 + sqrt(x)");
+        EXPECT_EQ(rows, evaluate_column_files(expr, TExpressionBindings(), { &xy, &zc }, output_path));
+        results = read_raw(output_path);
+    }
+    std::remove(interleaved_path.c_str());
+    std::remove(raw_path.c_str());
+    std::remove(output_path.c_str());
+
+    ASSERT_EQ(rows, results.size());
+    const TArithmeticExpression expr("x * y - z / 2 + sqrt(x)");
+    TExpressionBindings bindings;
+    for (size_t r = 0; r < rows; r += 997)
+    {
+        bindings.set("x", x[r]);
+        bindings.set("y", y[r]);
+        bindings.set("z", z[r]);
+        EXPECT_EQ(expr.calculate(bindings), results[r]) << r;
+    }
+}
+
+TEST(TColumnFile, rejects_mismatched_inputs)
+{
+    const std::string a_path = "test_tcolumn_file_a.bin";
+    const std::string b_path = "test_tcolumn_file_b.bin";
+    const std::string output_path = "test_tcolumn_file_mismatch.bin";
+    write_raw(a_path, { 1, 2, 3 });
+    write_raw(b_path, { 1, 2 });
+    {
+        const TColumnFile a = TColumnFile::open_raw(a_path, "a");
+        const TColumnFile b = TColumnFile::open_raw(b_path, "b");
+
+        const TArithmeticExpression sum("a + b");
+        EXPECT_THROW(evaluate_column_files(sum, TExpressionBindings(), { &a, &b }, output_path), column_file_error);
+
+        const TArithmeticExpression unbound("a + columnMissing");
+        EXPECT_THROW(evaluate_column_files(unbound, TExpressionBindings(), { &a }, output_path), std::invalid_argument);
+
+        // a raw file is not an interleaved one
+        EXPECT_THROW(TColumnFile file = TColumnFile::open_interleaved(a_path), column_file_error);
+    }
+    std::remove(a_path.c_str());
+    std::remove(b_path.c_str());
+    std::remove(output_path.c_str());
+}
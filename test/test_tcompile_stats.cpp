@@ -0,0 +1,54 @@
+#include <gtest.h>
+#include "compile_stats.h"
+#include "postfix.h"
+
+TEST(TCompileStats, records_last_compilation)
+{
+    TArithmeticExpression expr("(a + b) * sin(c) - 2");
+    const TCompileStats stats = TCompileStats::last();
+
+    if (!TCompileStats::enabled())
+    {
+        EXPECT_EQ(0, stats.compilations);
+        return;
+    }
+
+    EXPECT_EQ(1, stats.compilations);
+    EXPECT_EQ(0, stats.failures);
+    EXPECT_EQ(8, stats.tokens);
+    EXPECT_EQ(3, stats.stack_high_water);
+    // the program fits the list it was given, the stacks stay inline
+    EXPECT_EQ(0, stats.list_allocations);
+    EXPECT_GT(stats.total_ns(), 0);
+
+    TArithmeticExpression longer("(a + b) * sin(c) - 2 * d + e / f");
+    EXPECT_GT(TCompileStats::last().list_allocations, 0);
+}
+
+TEST(TCompileStats, records_failed_compilation)
+{
+    EXPECT_ANY_THROW(TArithmeticExpression expr("(a + b"));
+    const TCompileStats stats = TCompileStats::last();
+
+    if (!TCompileStats::enabled())
+    {
+        EXPECT_EQ(0, stats.failures);
+        return;
+    }
+
+    EXPECT_EQ(1, stats.compilations);
+    EXPECT_EQ(1, stats.failures);
+}
+
+TEST(TCompileStats, aggregates_compilations_globally)
+{
+    TCompileStats::reset_global();
+    for (int i = 0; i < 10; i++)
+    {
+        TArithmeticExpression expr("x * x + 1");
+    }
+    const TCompileStats stats = TCompileStats::global();
+
+    EXPECT_EQ(TCompileStats::enabled() ? 10 : 0, stats.compilations);
+    EXPECT_EQ(TCompileStats::enabled() ? 50 : 0, stats.tokens);
+}
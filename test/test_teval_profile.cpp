@@ -0,0 +1,123 @@
+#include <gtest.h>
+#include "eval_profile.h"
+#include "postfix.h"
+#include <algorithm>
+
+TEST(TEvaluationProfile, counts_executed_operations)
+{
+    TEvaluationProfile::reset();
+    TArithmeticExpression expr("(a + 2) * a");
+    for (int i = 0; i < 5; i++)
+    {
+        const double result = expr.calculate({ { "a", 3 } });
+        EXPECT_EQ(15, result);
+    }
+
+    const auto operations = TEvaluationProfile::hottest_operations(100);
+    if (!TEvaluationProfile::enabled())
+    {
+        EXPECT_TRUE(operations.empty());
+        return;
+    }
+
+    const auto find = [&operations](const std::string& label) {
+        return std::find_if(operations.begin(), operations.end(), [&label](const auto& e) { return e.label == label; });
+    };
+    ASSERT_NE(operations.end(), find("variable a"));
+    EXPECT_EQ(10, find("variable a")->count);
+    ASSERT_NE(operations.end(), find("operator *"));
+    EXPECT_EQ(5, find("operator *")->count);
+    EXPECT_EQ(5, find("number")->count);
+}
+
+TEST(TEvaluationProfile, attributes_operations_to_subexpressions)
+{
+    TEvaluationProfile::reset();
+    TArithmeticExpression expr("(a + 2) * sin(a)");
+    const double result = expr.calculate({ { "a", 0 } });
+    EXPECT_EQ(0, result);
+
+    // each occurrence of a is a subexpression of its own
+    const auto subexpressions = TEvaluationProfile::hottest_subexpressions(100);
+    if (!TEvaluationProfile::enabled())
+    {
+        EXPECT_TRUE(subexpressions.empty());
+        return;
+    }
+
+    std::vector<std::string> labels;
+    for (const auto& entry : subexpressions)
+    {
+        labels.push_back(entry.label);
+    }
+    std::sort(labels.begin(), labels.end());
+
+    const std::string prefix = "(a + 2) * sin(a): ";
+    const std::vector<std::string> expected = {
+        prefix + "(a + 2) * sin(a)",
+        prefix + "2",
+        prefix + "a",
+        prefix + "a",
+        prefix + "a + 2",
+        prefix + "sin(a)",
+    };
+    EXPECT_EQ(expected, labels);
+}
+
+TEST(TEvaluationProfile, balances_subexpressions_inside_nested_brackets)
+{
+    TEvaluationProfile::reset();
+    TArithmeticExpression expr("((a + 1)) * (2 - (a))");
+    const double result = expr.calculate({ { "a", 1 } });
+    EXPECT_EQ(2, result);
+
+    const auto subexpressions = TEvaluationProfile::hottest_subexpressions(100);
+    if (!TEvaluationProfile::enabled())
+    {
+        EXPECT_TRUE(subexpressions.empty());
+        return;
+    }
+
+    std::vector<std::string> labels;
+    for (const auto& entry : subexpressions)
+    {
+        labels.push_back(entry.label);
+    }
+    std::sort(labels.begin(), labels.end());
+
+    const std::string prefix = "((a + 1)) * (2 - (a)): ";
+    const std::vector<std::string> expected = {
+        prefix + "((a + 1)) * (2 - (a))",
+        prefix + "1",
+        prefix + "2",
+        prefix + "2 - (a)",
+        prefix + "a",
+        prefix + "a",
+        prefix + "a + 1",
+    };
+    EXPECT_EQ(expected, labels);
+}
+
+TEST(TEvaluationProfile, profiles_deeply_nested_expressions)
+{
+    TEvaluationProfile::reset();
+    const size_t depth = 100000;
+    std::string infix;
+    for (size_t i = 0; i < depth; i++)
+    {
+        infix += "1+(";
+    }
+    infix += "1";
+    infix += std::string(depth, ')');
+
+    TArithmeticExpression expr(infix);
+    EXPECT_EQ(depth + 1, expr.calculate());
+
+    const auto subexpressions = TEvaluationProfile::hottest_subexpressions(3);
+    if (!TEvaluationProfile::enabled())
+    {
+        EXPECT_TRUE(subexpressions.empty());
+        return;
+    }
+    EXPECT_EQ(3, subexpressions.size());
+}
@@ -0,0 +1,78 @@
+#include <gtest.h>
+#include "generator.h"
+#include "postfix.h"
+#include <algorithm>
+
+TEST(TExpressionGenerator, is_deterministic_for_a_seed)
+{
+    TExpressionGenerator first({}, 7), second({}, 7), other({}, 8);
+
+    const std::string expression = first.next();
+    EXPECT_EQ(expression, second.next());
+    EXPECT_NE(expression, other.next());
+}
+
+TEST(TExpressionGenerator, generates_valid_expressions)
+{
+    TGeneratorOptions options;
+    options.tokens = 50;
+    options.operators = "+-*/^";
+    options.unary_minus = 0.3;
+    options.bracket_density = 0.5;
+    TExpressionGenerator generator(options);
+
+    TExpressionBindings bindings;
+    for (const auto& name : generator.variable_names())
+    {
+        bindings.set(name, 1.5);
+    }
+
+    for (int i = 0; i < 1000; i++)
+    {
+        const std::string infix = generator.next();
+        ASSERT_NO_THROW((void)TArithmeticExpression(infix).calculate(bindings)) << infix;
+    }
+}
+
+TEST(TExpressionGenerator, respects_requested_size)
+{
+    for (const size_t tokens : { 10, 1000, 100000 })
+    {
+        TGeneratorOptions options;
+        options.tokens = tokens;
+        const TArithmeticExpression expr(TExpressionGenerator(options).next());
+
+        EXPECT_GE(expr.get_postfix().size(), tokens);
+        EXPECT_LE(expr.get_postfix().size(), tokens + 4);
+    }
+}
+
+TEST(TExpressionGenerator, respects_nesting_limit)
+{
+    TGeneratorOptions options;
+    options.tokens = 10000;
+    options.max_depth = 3;
+    options.bracket_density = 0.9;
+    options.close_density = 0.1;
+    const std::string infix = TExpressionGenerator(options).next();
+
+    int depth = 0, deepest = 0;
+    for (const char c : infix)
+    {
+        depth += c == '(' ? 1 : c == ')' ? -1 : 0;
+        deepest = std::max(deepest, depth);
+    }
+    EXPECT_EQ(3, deepest);
+}
+
+TEST(TExpressionGenerator, can_generate_numbers_only)
+{
+    TGeneratorOptions options;
+    options.variables = 0;
+    options.functions.clear();
+    TExpressionGenerator generator(options);
+
+    const TArithmeticExpression expr(generator.next());
+    EXPECT_TRUE(expr.get_variables().empty());
+    EXPECT_TRUE(expr.get_functions().empty());
+}
@@ -0,0 +1,107 @@
+#include <gtest.h>
+#include "image.h"
+#include "registry.h"
+#include <cstdio>
+
+// rewrites the checksum after a test changed the header
+static void reseal(std::string& image)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < image.size(); i++)
+    {
+        if (i >= 16 && i < 24)
+            continue;
+        hash ^= (unsigned char)image[i];
+        hash *= 1099511628211ull;
+    }
+    for (int i = 0; i < 8; i++)
+        image[16 + i] = (char)(uint8_t)(hash >> (8 * i));
+}
+
+TEST(TExpressionImage, restores_expression)
+{
+    const TArithmeticExpression source("-a + 2.5 * f(b) - 3! + pi");
+    const TArithmeticExpression restored = TExpressionImage::decode_single(TExpressionImage::encode(source));
+
+    EXPECT_EQ(source.get_infix(), restored.get_infix());
+    EXPECT_EQ(source.get_postfix(), restored.get_postfix());
+    EXPECT_EQ(source.get_variables(), restored.get_variables());
+    EXPECT_EQ(source.get_functions(), restored.get_functions());
+
+    const std::map<std::string, std::shared_ptr<TArithmeticExpressionFunction>> funcs = {
+        { "f", std::make_shared<TExplicitArithmeticExpressionFunction>(TArithmeticExpression("x*x")) },
+    };
+    EXPECT_EQ(source.calculate({ { "a", 1 }, { "b", 3 } }, funcs), restored.calculate({ { "a", 1 }, { "b", 3 } }, funcs));
+}
+
+TEST(TExpressionImage, detects_corruption)
+{
+    std::string image = TExpressionImage::encode(TArithmeticExpression("1+2"));
+    image[image.size() - 1] ^= 1;
+
+    EXPECT_THROW(const auto entries = TExpressionImage::decode(image), expression_image_error);
+    EXPECT_THROW(const auto entries = TExpressionImage::decode("nonsense"), expression_image_error);
+
+    // the header is checksummed as well
+    image = TExpressionImage::encode(TArithmeticExpression("1+2"));
+    image[8] ^= 1;
+    EXPECT_THROW(const auto entries = TExpressionImage::decode(image), expression_image_error);
+}
+
+TEST(TExpressionImage, rejects_counts_beyond_the_image)
+{
+    std::string image = TExpressionImage::encode(TArithmeticExpression("1+2"));
+    image[11] = 0x7f;
+    reseal(image);
+
+    EXPECT_THROW(const auto entries = TExpressionImage::decode(image), expression_image_error);
+}
+
+TEST(TExpressionImage, rejects_names_missing_from_the_lists)
+{
+    // both entries of the variable list name the same string, leaving a token unlisted
+    std::string image = TExpressionImage::encode(TArithmeticExpression("x+y"));
+    size_t list = image.find(std::string("\x02\0\0\0\0\0\0\0\x01\0\0\0", 12));
+    if (list == std::string::npos)
+        list = image.find(std::string("\x02\0\0\0\x01\0\0\0\0\0\0\0", 12));
+    ASSERT_NE(std::string::npos, list);
+    image[list + 8] = image[list + 4];
+    reseal(image);
+    EXPECT_THROW(const auto entries = TExpressionImage::decode(image), expression_image_error);
+
+    // the function list names the variable instead of the function
+    image = TExpressionImage::encode(TArithmeticExpression("f(x)"));
+    list = image.find(std::string("\x01\0\0\0\0\0\0\0\x01\0\0\0\x01\0\0\0", 16));
+    ASSERT_NE(std::string::npos, list);
+    image[list + 12] = 0;
+    reseal(image);
+    EXPECT_THROW(const auto entries = TExpressionImage::decode(image), expression_image_error);
+}
+
+TEST(TExpressionImage, recompiles_images_of_other_versions)
+{
+    std::string image = TExpressionImage::encode(TArithmeticExpression("x*(1+2)"));
+    image[4] = (char)(TExpressionImage::VERSION + 1);
+    reseal(image);
+
+    bool recompiled = false;
+    const auto entries = TExpressionImage::decode(image, &recompiled);
+
+    EXPECT_TRUE(recompiled);
+    ASSERT_EQ(1, entries.size());
+    EXPECT_EQ(6, entries[0].expression->calculate({ { "x", 2 } }));
+}
+
+TEST(TExpressionImage, registry_round_trip)
+{
+    const std::string path = "test_timage_registry.bin";
+    const auto registry = TFormulaRegistry::parse("area = pi * r ^ 2\nsum = a + b\n");
+    registry.save_image(path);
+
+    const auto restored = TFormulaRegistry::load_image(path);
+    std::remove(path.c_str());
+
+    ASSERT_EQ(2, restored.size());
+    EXPECT_EQ(5, restored.find("sum")->calculate({ { "a", 2 }, { "b", 3 } }));
+    EXPECT_EQ(registry.find("area")->calculate({ { "r", 2 } }), restored.find("area")->calculate({ { "r", 2 } }));
+}
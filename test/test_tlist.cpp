@@ -1,5 +1,8 @@
 #include <gtest.h>
 #include "list.h"
+#include <memory>
+#include <memory_resource>
+#include <string>
 
 TEST(TDynamicList, can_insert_to_begin)
 {
@@ -11,4 +14,243 @@ TEST(TDynamicList, can_insert_to_begin)
     list.insert(0, 5);
 
     EXPECT_EQ(5, list[0]);
-}
\ No newline at end of file
+}
+
+TEST(TDynamicList, can_insert_to_middle_and_end)
+{
+    TDynamicList<std::string> list(1);
+    list.push_back("a");
+    list.push_back("c");
+
+    list.insert(1, "b");
+    list.insert(3, "d");
+
+    ASSERT_EQ(4, list.size());
+    EXPECT_EQ("a", list[0]);
+    EXPECT_EQ("b", list[1]);
+    EXPECT_EQ("c", list[2]);
+    EXPECT_EQ("d", list[3]);
+}
+
+TEST(TDynamicList, can_remove)
+{
+    TDynamicList<std::string> list;
+    list.push_back("a");
+    list.push_back("b");
+    list.push_back("c");
+
+    list.remove(1);
+
+    ASSERT_EQ(2, list.size());
+    EXPECT_EQ("a", list[0]);
+    EXPECT_EQ("c", list[1]);
+}
+
+namespace
+{
+    struct TMoveOnly
+    {
+        std::unique_ptr<int> value;
+
+        explicit TMoveOnly(int value) : value(std::make_unique<int>(value)) {}
+    };
+}
+
+TEST(TDynamicList, growth_moves_elements)
+{
+    TDynamicList<TMoveOnly> list(1);
+    for (int i = 0; i < 100; i++)
+    {
+        list.emplace_back(i);
+    }
+
+    ASSERT_EQ(100, list.size());
+    for (int i = 0; i < 100; i++)
+    {
+        EXPECT_EQ(i, *list[i].value);
+    }
+}
+
+TEST(TDynamicList, can_push_back_own_element_while_growing)
+{
+    TDynamicList<std::string> list(1);
+    list.push_back(std::string(100, 'x'));
+
+    list.push_back(list[0]);
+
+    ASSERT_EQ(2, list.size());
+    EXPECT_EQ(list[0], list[1]);
+}
+
+TEST(TDynamicList, reserve_keeps_elements)
+{
+    TDynamicList<double> list(1);
+    list.push_back(1.5);
+
+    list.reserve(1000);
+
+    EXPECT_EQ(1000, list.get_capacity());
+    ASSERT_EQ(1, list.size());
+    EXPECT_EQ(1.5, list[0]);
+}
+
+TEST(TDynamicList, reserve_never_shrinks)
+{
+    TDynamicList<double> list(16);
+
+    list.reserve(4);
+
+    EXPECT_EQ(16, list.get_capacity());
+}
+
+TEST(TDynamicList, can_grow_after_shrinking_empty_list)
+{
+    TDynamicList<int> list;
+    list.shrink_to_fit();
+
+    list.push_back(1);
+    list.push_back(2);
+
+    EXPECT_EQ(2, list.size());
+}
+
+TEST(TDynamicList, small_list_stays_inline)
+{
+    TDynamicList<double, 4> list(2);
+    for (int i = 0; i < 4; i++)
+    {
+        list.push_back(i);
+    }
+
+    EXPECT_EQ(0, list.allocated_bytes());
+    EXPECT_EQ(4, list.get_capacity());
+}
+
+TEST(TDynamicList, inline_list_spills_to_heap)
+{
+    TDynamicList<std::string, 4> list;
+    for (int i = 0; i < 10; i++)
+    {
+        list.push_back(std::to_string(i));
+    }
+
+    EXPECT_NE(0, list.allocated_bytes());
+    ASSERT_EQ(10, list.size());
+    for (int i = 0; i < 10; i++)
+    {
+        EXPECT_EQ(std::to_string(i), list[i]);
+    }
+}
+
+TEST(TDynamicList, can_copy_and_move_inline_list)
+{
+    TDynamicList<std::string, 4> list;
+    list.push_back("a");
+    list.push_back("b");
+
+    TDynamicList<std::string, 4> copy(list);
+    TDynamicList<std::string, 4> moved(std::move(list));
+
+    EXPECT_EQ(copy, moved);
+    EXPECT_EQ(0, moved.allocated_bytes());
+    EXPECT_TRUE(list.empty());
+}
+
+TEST(TDynamicList, can_swap_inline_and_heap_lists)
+{
+    TDynamicList<std::string, 2> small;
+    small.push_back("a");
+    TDynamicList<std::string, 2> large;
+    for (int i = 0; i < 5; i++)
+    {
+        large.push_back(std::to_string(i));
+    }
+
+    swap(small, large);
+
+    ASSERT_EQ(5, small.size());
+    EXPECT_EQ("4", small[4]);
+    ASSERT_EQ(1, large.size());
+    EXPECT_EQ("a", large[0]);
+    EXPECT_EQ(0, large.allocated_bytes());
+}
+
+TEST(TDynamicList, shrinking_returns_to_inline_storage)
+{
+    TDynamicList<int, 4> list;
+    for (int i = 0; i < 10; i++)
+    {
+        list.push_back(i);
+    }
+    while (list.size() > 2)
+    {
+        list.remove(list.size() - 1);
+    }
+
+    list.shrink_to_fit();
+
+    EXPECT_EQ(0, list.allocated_bytes());
+    EXPECT_EQ(1, list[1]);
+}
+
+TEST(TDynamicList, takes_storage_from_memory_resource)
+{
+    char buffer[1024];
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+    TDynamicList<double> list(2, &arena);
+    for (int i = 0; i < 16; i++)
+    {
+        list.push_back(i);
+    }
+
+    EXPECT_EQ(&arena, list.get_resource());
+    EXPECT_GE((char*)list.begin(), buffer);
+    EXPECT_LT((char*)list.begin(), buffer + sizeof(buffer));
+    EXPECT_EQ(15, list[15]);
+}
+
+TEST(TDynamicList, copy_does_not_share_memory_resource)
+{
+    std::pmr::monotonic_buffer_resource arena;
+    TDynamicList<double> list(2, &arena);
+    list.push_back(1);
+
+    TDynamicList<double> copy(list);
+
+    EXPECT_EQ(nullptr, copy.get_resource());
+    EXPECT_EQ(list, copy);
+}
+
+// hands out heap memory and notes deallocations of null pointers
+class TNullCheckingResource : public std::pmr::memory_resource {
+public:
+    size_t null_deallocations = 0;
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+    {
+        if (p == nullptr)
+            null_deallocations++;
+        else
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+TEST(TDynamicList, moved_from_list_returns_no_memory)
+{
+    TNullCheckingResource resource;
+    {
+        TDynamicList<double> list(2, &resource);
+        list.push_back(1);
+        TDynamicList<double> moved(std::move(list));
+        EXPECT_EQ(1, moved[0]);
+    }
+    EXPECT_EQ(0, resource.null_deallocations);
+}
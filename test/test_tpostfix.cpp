@@ -1,5 +1,8 @@
 #include <gtest.h>
 #include "postfix.h"
+#include <cmath>
+#include <memory>
+#include <memory_resource>
 
 TEST(TArithmeticExpression, can_parse_complex_expressions)
 {
@@ -171,3 +174,439 @@ TEST(TArithmeticExpression, validator_detects_bad_numbers)
     EXPECT_ANY_THROW(TArithmeticExpression expr("1.+1"));
     EXPECT_ANY_THROW(TArithmeticExpression expr("1.x+1"));
 }
+
+TEST(TArithmeticExpression, builds_postfix_form)
+{
+    TArithmeticExpression expr("a+b*(c-d)");
+    const auto postfix = expr.get_postfix();
+
+    const std::string expected[] = { "a", "b", "c", "d", "-", "*", "+" };
+    ASSERT_EQ(7, postfix.size());
+    for (size_t i = 0; i < postfix.size(); i++)
+    {
+        EXPECT_EQ(expected[i], postfix[i]);
+    }
+}
+
+TEST(TArithmeticExpression, collects_variables_and_functions)
+{
+    TArithmeticExpression expr("f(a) + sin(b) * pi");
+
+    const auto variables = expr.get_variables();
+    ASSERT_EQ(2, variables.size());
+    EXPECT_EQ("a", variables[0]);
+    EXPECT_EQ("b", variables[1]);
+
+    const auto functions = expr.get_functions();
+    ASSERT_EQ(1, functions.size());
+    EXPECT_EQ("f", functions[0]);
+}
+
+TEST(TArithmeticExpression, lists_names_in_alphabetical_order)
+{
+    TArithmeticExpression expr("zeta + alpha * f(mu) + g(beta)");
+
+    const std::string variables[] = { "alpha", "beta", "mu", "zeta" };
+    ASSERT_EQ(4, expr.get_variables().size());
+    EXPECT_TRUE(std::equal(variables, variables + 4, expr.get_variables().begin()));
+
+    const std::string functions[] = { "f", "g" };
+    ASSERT_EQ(2, expr.get_functions().size());
+    EXPECT_TRUE(std::equal(functions, functions + 2, expr.get_functions().begin()));
+}
+
+TEST(TArithmeticExpression, builds_postfix_text)
+{
+    TArithmeticExpression expr("-(2.50 + x) * 3!");
+
+    // the unary minus applies to the whole product
+    EXPECT_EQ(" 2.50 x + 3  ! * -", expr.get_postfix_text());
+}
+
+TEST(TArithmeticExpression, copies_share_postfix_text)
+{
+    TArithmeticExpression expr("a+b*(c-d)");
+    const std::string_view text = expr.get_postfix_text();
+
+    const TArithmeticExpression copy(expr);
+
+    EXPECT_EQ(text.data(), copy.get_postfix_text().data());
+}
+
+TEST(TArithmeticExpression, postfix_shows_numbers_joined_across_spaces)
+{
+    const TArithmeticExpression expr("1 2+3 .5");
+
+    EXPECT_EQ(15.5, expr.calculate());
+    EXPECT_EQ("12 3.5 +", expr.get_postfix_text());
+}
+
+TEST(TArithmeticExpression, validator_reports_cause_and_position)
+{
+    try {
+        TArithmeticExpression expr("(1+2)*(3");
+        FAIL();
+    } catch (const expression_validation_error& err) {
+        EXPECT_EQ(expression_validation_error::cause::MissingBracket, err.get_cause());
+        EXPECT_EQ(7, err.get_pos());
+    }
+
+    try {
+        TArithmeticExpression expr("1+2*/3");
+        FAIL();
+    } catch (const expression_validation_error& err) {
+        EXPECT_EQ(expression_validation_error::cause::BadOperator, err.get_cause());
+        EXPECT_EQ(5, err.get_pos());
+    }
+}
+
+TEST(TArithmeticExpression, validation_errors_win_over_later_stages)
+{
+    // the malformed number comes first, the missing bracket is reported
+    try {
+        TArithmeticExpression expr("1.2.3+(");
+        FAIL();
+    } catch (const expression_validation_error& err) {
+        EXPECT_EQ(expression_validation_error::cause::MissingBracket, err.get_cause());
+        EXPECT_EQ(7, err.get_pos());
+    }
+
+    try {
+        TArithmeticExpression expr("1.2.3*2+*3");
+        FAIL();
+    } catch (const expression_validation_error& err) {
+        EXPECT_EQ(expression_validation_error::cause::BadOperator, err.get_cause());
+        EXPECT_EQ(9, err.get_pos());
+    }
+
+    // with a valid rest of the input the malformed number is reported after all
+    try {
+        TArithmeticExpression expr("1.2.3+(4)");
+        FAIL();
+    } catch (const expression_validation_error& err) {
+        EXPECT_EQ(expression_validation_error::cause::BadNumber, err.get_cause());
+        EXPECT_EQ(1, err.get_pos());
+    }
+}
+
+TEST(TArithmeticExpression, validator_rejects_adjacent_operands)
+{
+    const std::pair<const char*, size_t> inputs[] = {
+        { "(1)(2)", 4 },
+        { "(1) (2)", 5 },
+        { "(a)b", 4 },
+        { "3!2", 3 },
+        { "2! (x)", 4 },
+    };
+    for (const auto& [infix, pos] : inputs)
+    {
+        try {
+            TArithmeticExpression expr(infix);
+            ADD_FAILURE() << infix;
+        } catch (const expression_validation_error& err) {
+            EXPECT_EQ(expression_validation_error::cause::MissingOperator, err.get_cause()) << infix;
+            EXPECT_EQ(pos, err.get_pos()) << infix;
+        }
+    }
+
+    EXPECT_EQ(8, TArithmeticExpression("(1)*(2)+3!").calculate());
+}
+
+TEST(TArithmeticExpression, validator_rejects_calls_without_argument)
+{
+    const std::pair<const char*, size_t> inputs[] = {
+        { "f()", 3 },
+        { "sin( )", 6 },
+        { "1 + cos ()", 10 },
+    };
+    for (const auto& [infix, pos] : inputs)
+    {
+        try {
+            TArithmeticExpression expr(infix);
+            ADD_FAILURE() << infix;
+        } catch (const expression_validation_error& err) {
+            EXPECT_EQ(expression_validation_error::cause::EmptyCall, err.get_cause()) << infix;
+            EXPECT_EQ(pos, err.get_pos()) << infix;
+        }
+    }
+
+    // empty brackets without a name are still an empty expression
+    EXPECT_NO_THROW(TArithmeticExpression expr("( )"));
+    EXPECT_NO_THROW(TArithmeticExpression expr("(())"));
+    EXPECT_EQ(0, TArithmeticExpression("sin (0)").calculate());
+}
+
+TEST(TArithmeticExpression, validator_rejects_empty_brackets_as_operand)
+{
+    const std::pair<const char*, size_t> inputs[] = {
+        { "1+()", 4 },
+        { "()*2", 3 },
+        { "(())!", 5 },
+    };
+    for (const auto& [infix, pos] : inputs)
+    {
+        try {
+            TArithmeticExpression expr(infix);
+            ADD_FAILURE() << infix;
+        } catch (const expression_validation_error& err) {
+            EXPECT_EQ(expression_validation_error::cause::MissingOperand, err.get_cause()) << infix;
+            EXPECT_EQ(pos, err.get_pos()) << infix;
+        }
+    }
+
+    // operators other than minus cannot open a bracket either
+    try {
+        TArithmeticExpression expr("2*(*3)");
+        FAIL();
+    } catch (const expression_validation_error& err) {
+        EXPECT_EQ(expression_validation_error::cause::BadOperator, err.get_cause());
+        EXPECT_EQ(4, err.get_pos());
+    }
+    EXPECT_EQ(-6, TArithmeticExpression("2*(-3)").calculate());
+}
+
+TEST(TArithmeticExpression, validator_skips_spaces_between_symbols)
+{
+    try {
+        TArithmeticExpression expr("1 + + 2");
+        FAIL();
+    } catch (const expression_validation_error& err) {
+        EXPECT_EQ(expression_validation_error::cause::BadOperator, err.get_cause());
+        EXPECT_EQ(5, err.get_pos());
+    }
+
+    try {
+        TArithmeticExpression expr("1 + ");
+        FAIL();
+    } catch (const expression_validation_error& err) {
+        EXPECT_EQ(expression_validation_error::cause::BadOperator, err.get_cause());
+    }
+
+    // a dot still wants its fraction right after it
+    try {
+        TArithmeticExpression expr("1. 5");
+        FAIL();
+    } catch (const expression_validation_error& err) {
+        EXPECT_EQ(expression_validation_error::cause::BadNumber, err.get_cause());
+        EXPECT_EQ(3, err.get_pos());
+    }
+}
+
+TEST(TArithmeticExpression, parses_numbers_exactly)
+{
+    TArithmeticExpression expr("0.1+0.2");
+    EXPECT_EQ(0.1+0.2, expr.calculate());
+}
+
+TEST(TArithmeticExpression, reports_malformed_number_position)
+{
+    try {
+        TArithmeticExpression expr("2*1.2.3");
+        FAIL();
+    } catch (const expression_validation_error& err) {
+        EXPECT_EQ(expression_validation_error::cause::BadNumber, err.get_cause());
+        EXPECT_EQ(3, err.get_pos());
+    }
+}
+
+TEST(TArithmeticExpression, supports_all_binary_operators)
+{
+    EXPECT_EQ(7 + 3, TArithmeticExpression("7+3").calculate());
+    EXPECT_EQ(7 - 3, TArithmeticExpression("7-3").calculate());
+    EXPECT_EQ(7 * 3, TArithmeticExpression("7*3").calculate());
+    EXPECT_EQ(7.0 / 2, TArithmeticExpression("7/2").calculate());
+    EXPECT_EQ(7 % 3, TArithmeticExpression("7%3").calculate());
+    EXPECT_EQ(8, TArithmeticExpression("2^3").calculate());
+}
+
+TEST(TArithmeticExpression, validator_handles_operator_special_cases)
+{
+    EXPECT_NO_THROW(TArithmeticExpression expr("5!+1"));
+    EXPECT_NO_THROW(TArithmeticExpression expr("(3!)"));
+
+    try {
+        TArithmeticExpression expr("!5");
+        FAIL();
+    } catch (const expression_validation_error& err) {
+        EXPECT_EQ(expression_validation_error::cause::BadOperator, err.get_cause());
+        EXPECT_EQ(1, err.get_pos());
+    }
+
+    try {
+        TArithmeticExpression expr("2+1a");
+        FAIL();
+    } catch (const expression_validation_error& err) {
+        EXPECT_EQ(expression_validation_error::cause::BadNumber, err.get_cause());
+        EXPECT_EQ(4, err.get_pos());
+    }
+
+    try {
+        TArithmeticExpression expr("2*3-");
+        FAIL();
+    } catch (const expression_validation_error& err) {
+        EXPECT_EQ(expression_validation_error::cause::BadOperator, err.get_cause());
+        EXPECT_EQ(4, err.get_pos());
+    }
+}
+
+TEST(TArithmeticExpression, can_handle_deeply_nested_brackets)
+{
+    const size_t depth = 100000;
+    const std::string infix = std::string(depth, '(') + "1+x" + std::string(depth, ')');
+
+    TArithmeticExpression expr(infix);
+    EXPECT_EQ(3, expr.calculate({ { "x", 2 } }));
+}
+
+TEST(TArithmeticExpression, can_handle_long_right_nested_chains)
+{
+    const size_t depth = 100000;
+    std::string infix;
+    for (size_t i = 0; i < depth; i++)
+    {
+        infix += "1-(";
+    }
+    infix += "1" + std::string(depth, ')');
+
+    // 1-(1-(1-...)) alternates between 0 and 1
+    TArithmeticExpression expr(infix);
+    EXPECT_EQ(depth % 2 == 0 ? 1 : 0, expr.calculate());
+}
+
+namespace
+{
+    class TCountingResource : public std::pmr::memory_resource
+    {
+    public:
+        size_t allocated = 0;
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override
+        {
+            allocated += bytes;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override
+        {
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+}
+
+TEST(TArithmeticExpression, takes_all_storage_from_arena)
+{
+    TCountingResource arena;
+    TArithmeticExpression expr("aRatherLongVariableName * (b + c) - sin(aRatherLongVariableName) / 2", &arena);
+
+    EXPECT_GT(arena.allocated, 0);
+    EXPECT_GE(arena.allocated, expr.memory_usage() - sizeof(expr));
+    EXPECT_DOUBLE_EQ(7 - sin(1) / 2, expr.calculate({ { "aRatherLongVariableName", 1 }, { "b", 3 }, { "c", 4 } }));
+}
+
+TEST(TArithmeticExpression, copy_outlives_arena)
+{
+    auto arena = std::make_unique<std::pmr::monotonic_buffer_resource>();
+    auto expr = std::make_unique<TArithmeticExpression>("x * (x + 1) + someLongVariableName", arena.get());
+
+    const TArithmeticExpression copy(*expr);
+    expr.reset();
+    arena.reset();
+
+    EXPECT_EQ(6, copy.calculate({ { "x", 2 }, { "someLongVariableName", 0 } }));
+    EXPECT_EQ("x * (x + 1) + someLongVariableName", copy.get_infix());
+}
+
+TEST(TArithmeticExpression, throws_when_calculating_empty_expression)
+{
+    TArithmeticExpression expr("( )");
+    EXPECT_THROW((void)expr.calculate(), std::logic_error);
+}
+
+TEST(TArithmeticExpression, can_calculate_programs_deeper_than_inline_stack)
+{
+    // every operand stays on the stack until the brackets close
+    std::string infix;
+    for (int i = 0; i < 100; i++)
+    {
+        infix += "1+(";
+    }
+    infix += "1" + std::string(100, ')');
+
+    TArithmeticExpression expr(infix);
+    EXPECT_EQ(101, expr.calculate());
+}
+
+TEST(TArithmeticExpression, calculate_batch_matches_calculate)
+{
+    // more rows than a block, and not a multiple of it
+    const size_t rows = 1000;
+    std::vector<double> a(rows), b(rows);
+    for (size_t r = 0; r < rows; r++)
+    {
+        a[r] = r * 0.5 - 100;
+        b[r] = r % 7 + 1;
+    }
+
+    TArithmeticExpression expr("-a * (b + 2) / b - sin(a) + c ^ 2 % 5 + pi");
+    TExpressionBindings bindings;
+    bindings.set("c", 3);
+    TExpressionColumns columns;
+    columns.set("a", a.data());
+    columns.set("b", b.data());
+
+    std::vector<double> results(rows);
+    expr.calculate_batch(bindings, columns, rows, results.data());
+
+    for (size_t r = 0; r < rows; r++)
+    {
+        bindings.set("a", a[r]);
+        bindings.set("b", b[r]);
+        EXPECT_EQ(expr.calculate(bindings), results[r]) << r;
+    }
+}
+
+TEST(TArithmeticExpression, modulo_and_factorial_never_trap)
+{
+    EXPECT_EQ(-7 % 3, TArithmeticExpression("-7%3").calculate());
+    EXPECT_EQ(1, TArithmeticExpression("7.9%3.2").calculate());
+
+    const TArithmeticExpression expr("x % y + x!");
+    const double x[] = { 5, 5, 5, NAN, 1e300, 171 };
+    const double y[] = { 3, 0, 0.5, 2, 7, 1 };
+    const size_t rows = sizeof(x) / sizeof(x[0]);
+    TExpressionColumns columns;
+    columns.set("x", x);
+    columns.set("y", y);
+
+    double results[rows];
+    expr.calculate_batch(TExpressionBindings(), columns, rows, results);
+
+    EXPECT_EQ(122, results[0]);
+    EXPECT_TRUE(std::isnan(results[1]));
+    EXPECT_TRUE(std::isnan(results[2]));
+    EXPECT_TRUE(std::isnan(results[3]));
+    EXPECT_EQ(HUGE_VAL, results[4]);
+    EXPECT_EQ(HUGE_VAL, results[5]);
+
+    TExpressionBindings bindings;
+    bindings.set("x", 5);
+    bindings.set("y", 0);
+    EXPECT_TRUE(std::isnan(expr.calculate(bindings)));
+}
+
+TEST(TArithmeticExpression, calculate_batch_requires_all_variables)
+{
+    const double a[] = { 1, 2 };
+    TExpressionColumns columns;
+    columns.set("a", a);
+    double results[2];
+
+    TArithmeticExpression expr("a + batchMissing");
+    EXPECT_THROW(expr.calculate_batch(TExpressionBindings(), columns, 2, results), std::invalid_argument);
+
+    TArithmeticExpression empty("( )");
+    EXPECT_THROW(empty.calculate_batch(TExpressionBindings(), columns, 2, results), std::logic_error);
+}
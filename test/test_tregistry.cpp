@@ -0,0 +1,69 @@
+#include <gtest.h>
+#include "registry.h"
+#include <cstdio>
+#include <fstream>
+
+TEST(TFormulaRegistry, indexes_named_formulas)
+{
+    const auto registry = TFormulaRegistry::parse("area = pi * r ^ 2\n\nperimeter = 2 * pi * r\n1 + 2\n");
+
+    ASSERT_EQ(3, registry.size());
+    ASSERT_NE(nullptr, registry.find("area"));
+    EXPECT_EQ(4, registry.find("perimeter")->calculate({ { "r", 1 }, { "pi", 2 } }));
+    EXPECT_EQ(nullptr, registry.find("volume"));
+
+    EXPECT_EQ(4, registry.get_entries()[2].line);
+    EXPECT_EQ(3, registry.get_entries()[2].expression->calculate());
+}
+
+TEST(TFormulaRegistry, reports_errors_with_line_numbers)
+{
+    const auto registry = TFormulaRegistry::parse("a = 1 + 2\r\nb = (1 + 2\r\nc = 1 ++ 2\r\na = 3\r\n");
+
+    EXPECT_EQ(1, registry.size());
+    ASSERT_EQ(3, registry.get_errors().size());
+
+    const auto& bracket = registry.get_errors()[0];
+    EXPECT_EQ(2, bracket.line);
+    EXPECT_EQ(5, bracket.column);
+    EXPECT_EQ(expression_validation_error::cause::MissingBracket, bracket.cause);
+
+    EXPECT_EQ(3, registry.get_errors()[1].line);
+    EXPECT_EQ(expression_validation_error::cause::BadOperator, registry.get_errors()[1].cause);
+
+    EXPECT_EQ(4, registry.get_errors()[2].line);
+}
+
+TEST(TFormulaRegistry, reports_names_without_formula)
+{
+    const auto registry = TFormulaRegistry::parse("a = 1\nempty =\nblank =   \r\nb = 2\n");
+
+    EXPECT_EQ(2, registry.size());
+    EXPECT_EQ(nullptr, registry.find("empty"));
+    ASSERT_EQ(2, registry.get_errors().size());
+
+    EXPECT_EQ(2, registry.get_errors()[0].line);
+    EXPECT_EQ(8, registry.get_errors()[0].column);
+    EXPECT_EQ(3, registry.get_errors()[1].line);
+    EXPECT_EQ(8, registry.get_errors()[1].column);
+}
+
+TEST(TFormulaRegistry, can_load_file)
+{
+    const std::string path = "test_tregistry_catalog.txt";
+    {
+        std::ofstream out(path);
+        out << "double = 2 * x\n" << "square = x * x";
+    }
+
+    const auto registry = TFormulaRegistry::load(path);
+    std::remove(path.c_str());
+
+    ASSERT_EQ(2, registry.size());
+    EXPECT_EQ(9, registry.find("square")->calculate({ { "x", 3 } }));
+}
+
+TEST(TFormulaRegistry, throws_on_missing_file)
+{
+    EXPECT_ANY_THROW(const auto registry = TFormulaRegistry::load("no_such_catalog.txt"));
+}
@@ -6,9 +6,21 @@ TEST(TStack, can_create_stack_with_positive_length)
     ASSERT_NO_THROW(TStack<int> st(5));
 }
 
-TEST(TStack, cant_create_stack_with_too_large_length)
+TEST(TStack, can_create_stack_with_large_length)
 {
-    EXPECT_ANY_THROW(TStack<int> st(MAX_STACK_SIZE + 1));
+    ASSERT_NO_THROW(TStack<int> st(100000));
+}
+
+TEST(TStack, can_grow_without_limit)
+{
+    const int items = 1000000;
+    TStack<int> st;
+    for (int i = 0; i < items; i++)
+    {
+        st.push(i);
+    }
+    EXPECT_EQ(items, st.size());
+    EXPECT_EQ(items - 1, st.top());
 }
 
 TEST(TStack, fresh_stack_is_empty)
@@ -56,3 +68,46 @@ TEST(TStack, top_retrieves_last_element)
     st.push(3);
     EXPECT_EQ(3, st.top());
 }
+
+
+TEST(TStack, inline_stack_grows_past_its_inline_capacity)
+{
+    const int items = 100;
+    TStack<int, 8> st;
+    for (int i = 0; i < items; i++)
+    {
+        st.push(i);
+    }
+    for (int i = items - 1; i >= 0; i--)
+    {
+        EXPECT_EQ(i, st.pop_element());
+    }
+    EXPECT_TRUE(st.empty());
+}
+
+TEST(TUncheckedStack, can_push_and_pop_inline)
+{
+    TUncheckedStack<int, 4> st(3);
+    st.push(1);
+    st.push(2);
+    st.push(3);
+
+    EXPECT_EQ(3, st.pop_element());
+    EXPECT_EQ(2, st.top());
+    EXPECT_EQ(2, st.size());
+}
+
+TEST(TUncheckedStack, can_hold_more_than_inline_capacity)
+{
+    const int items = 100;
+    TUncheckedStack<int, 4> st(items);
+    for (int i = 0; i < items; i++)
+    {
+        st.push(i);
+    }
+    for (int i = items - 1; i >= 0; i--)
+    {
+        EXPECT_EQ(i, st.pop_element());
+    }
+    EXPECT_TRUE(st.empty());
+}
@@ -0,0 +1,71 @@
+#include <gtest.h>
+#include "symbols.h"
+#include "postfix.h"
+#include <thread>
+#include <vector>
+
+TEST(TSymbolTable, interns_names_to_stable_ids)
+{
+    TSymbolTable table;
+
+    const TSymbol a = table.intern("alpha");
+    const TSymbol b = table.intern("beta");
+
+    EXPECT_NE(a, b);
+    EXPECT_EQ(a, table.intern("alpha"));
+    EXPECT_EQ("beta", table.name(b));
+    EXPECT_EQ(2, table.size());
+}
+
+TEST(TSymbolTable, find_does_not_intern)
+{
+    TSymbolTable table;
+
+    EXPECT_EQ(TSymbolTable::NONE, table.find("gamma"));
+    EXPECT_EQ(0, table.size());
+}
+
+TEST(TSymbolTable, can_intern_concurrently)
+{
+    TSymbolTable table;
+
+    std::vector<std::thread> threads;
+    std::vector<std::vector<TSymbol>> ids(4);
+    for (size_t t = 0; t < ids.size(); t++)
+    {
+        threads.emplace_back([&table, &ids, t]() {
+            for (int i = 0; i < 500; i++)
+                ids[t].push_back(table.intern("v" + std::to_string(i)));
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    EXPECT_EQ(500, table.size());
+    for (size_t t = 1; t < ids.size(); t++)
+        EXPECT_EQ(ids[0], ids[t]);
+}
+
+TEST(TExpressionBindings, evaluates_by_symbol)
+{
+    TArithmeticExpression expr("a*b + f(a) + pi");
+
+    TExpressionBindings bindings;
+    bindings.set("a", 2);
+    bindings.set(TSymbolTable::global().intern("b"), 3);
+    bindings.set("pi", 1);
+    bindings.set_function("f", std::make_shared<TComputedArithmeticExpressionFunction>([](double x) { return x * 10; }));
+
+    EXPECT_EQ(2*3 + 20 + 1, expr.calculate(bindings));
+}
+
+TEST(TExpressionBindings, requires_all_symbols)
+{
+    TArithmeticExpression expr("a + f(b)");
+
+    TExpressionBindings bindings;
+    bindings.set("a", 1);
+    bindings.set("b", 1);
+
+    EXPECT_THROW((void)expr.calculate(bindings), std::invalid_argument);
+}